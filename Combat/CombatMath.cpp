@@ -0,0 +1,431 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "CombatMath.h"
+
+#include "Algo/StableSort.h"
+#include "Math/VectorRegister.h"
+
+namespace Y25::CombatMath
+{
+	namespace
+	{
+		//Candidates handled per register
+		constexpr int32 Lanes = 4;
+
+		//Shared by both NearestK implementations so they only differ in the distance pass
+		void SelectNearest(
+			const TArray<float, TInlineAllocator<256>>& DistSq,
+			const int32 K,
+			const float MaxDistance,
+			TArray<int32>& OutIndices)
+		{
+			OutIndices.Reset();
+
+			const float MaxDistanceSq = FMath::Square(MaxDistance);
+			for (int32 Index = 0; Index < DistSq.Num(); Index++)
+			{
+				if (DistSq[Index] <= MaxDistanceSq)
+				{
+					OutIndices.Add(Index);
+				}
+			}
+
+			//Stable so equal distances keep input order in both paths
+			Algo::StableSort(OutIndices, [&DistSq](const int32 A, const int32 B)
+			{
+				return DistSq[A] < DistSq[B];
+			});
+
+			if (OutIndices.Num() > K)
+			{
+				OutIndices.SetNum(FMath::Max(K, 0), EAllowShrinking::No);
+			}
+		}
+
+		//Random inputs for the cone, drawn in the same order by both paths
+		void DrawConeSamples(const int32 Count, FRandomStream& Stream, TArray<float>& OutU1, TArray<float>& OutU2)
+		{
+			OutU1.SetNumUninitialized(Count);
+			OutU2.SetNumUninitialized(Count);
+			for (int32 Index = 0; Index < Count; Index++)
+			{
+				OutU1[Index] = Stream.GetFraction();
+				OutU2[Index] = Stream.GetFraction();
+			}
+		}
+	}
+
+	void FPositionsSoA::Reset(const int32 Capacity)
+	{
+		X.Reset(Capacity);
+		Y.Reset(Capacity);
+		Z.Reset(Capacity);
+	}
+
+	void FPositionsSoA::SetNum(const int32 Num)
+	{
+		X.SetNumUninitialized(Num);
+		Y.SetNumUninitialized(Num);
+		Z.SetNumUninitialized(Num);
+	}
+
+	int32 FPositionsSoA::Add(const FVector& Position)
+	{
+		X.Add(Position.X);
+		Y.Add(Position.Y);
+		return Z.Add(Position.Z);
+	}
+
+	int32 FPositionsSoA::Num() const
+	{
+		return X.Num();
+	}
+
+	FVector FPositionsSoA::Get(const int32 Index) const
+	{
+		return FVector(X[Index], Y[Index], Z[Index]);
+	}
+
+	void DistanceSquared(const FPositionsSoA& Positions, const FVector& Origin, const TArrayView<float> OutDistSq)
+	{
+		const int32 Num = Positions.Num();
+		check(OutDistSq.Num() >= Num);
+
+		//Origin is double precision, positions are float, both paths work from the same float copy
+		const FVector3f Origin3f(Origin);
+		const VectorRegister4Float OriginX = VectorSetFloat1(Origin3f.X);
+		const VectorRegister4Float OriginY = VectorSetFloat1(Origin3f.Y);
+		const VectorRegister4Float OriginZ = VectorSetFloat1(Origin3f.Z);
+
+		int32 Index = 0;
+		for (; Index + Lanes <= Num; Index += Lanes)
+		{
+			const VectorRegister4Float DX = VectorSubtract(VectorLoad(&Positions.X[Index]), OriginX);
+			const VectorRegister4Float DY = VectorSubtract(VectorLoad(&Positions.Y[Index]), OriginY);
+			const VectorRegister4Float DZ = VectorSubtract(VectorLoad(&Positions.Z[Index]), OriginZ);
+
+			VectorRegister4Float Result = VectorMultiply(DX, DX);
+			Result = VectorMultiplyAdd(DY, DY, Result);
+			Result = VectorMultiplyAdd(DZ, DZ, Result);
+			VectorStore(Result, &OutDistSq[Index]);
+		}
+
+		//Leftovers that don't fill a register
+		for (; Index < Num; Index++)
+		{
+			const float DX = Positions.X[Index] - Origin3f.X;
+			const float DY = Positions.Y[Index] - Origin3f.Y;
+			const float DZ = Positions.Z[Index] - Origin3f.Z;
+			OutDistSq[Index] = DX * DX + DY * DY + DZ * DZ;
+		}
+	}
+
+	void FilterRadius(
+		const FPositionsSoA& Positions,
+		const FVector& Origin,
+		const float Radius,
+		TArray<int32>& OutIndices)
+	{
+		OutIndices.Reset();
+
+		const int32 Num = Positions.Num();
+		TArray<float, TInlineAllocator<256>> DistSq;
+		DistSq.SetNumUninitialized(Num);
+		DistanceSquared(Positions, Origin, DistSq);
+
+		const VectorRegister4Float RadiusSq = VectorSetFloat1(FMath::Square(Radius));
+
+		int32 Index = 0;
+		for (; Index + Lanes <= Num; Index += Lanes)
+		{
+			//One bit per lane inside the radius
+			uint32 Mask = VectorMaskBits(VectorCompareLE(VectorLoad(&DistSq[Index]), RadiusSq));
+			while (Mask)
+			{
+				OutIndices.Add(Index + FMath::CountTrailingZeros(Mask));
+				Mask &= Mask - 1;
+			}
+		}
+
+		const float ScalarRadiusSq = FMath::Square(Radius);
+		for (; Index < Num; Index++)
+		{
+			if (DistSq[Index] <= ScalarRadiusSq)
+			{
+				OutIndices.Add(Index);
+			}
+		}
+	}
+
+	void NearestK(
+		const FPositionsSoA& Positions,
+		const FVector& Origin,
+		const int32 K,
+		const float MaxDistance,
+		TArray<int32>& OutIndices)
+	{
+		TArray<float, TInlineAllocator<256>> DistSq;
+		DistSq.SetNumUninitialized(Positions.Num());
+		DistanceSquared(Positions, Origin, DistSq);
+
+		SelectNearest(DistSq, K, MaxDistance, OutIndices);
+	}
+
+	void Falloff(
+		const TConstArrayView<float> DistSq,
+		const float Radius,
+		const float Value,
+		const float MinScale,
+		const TArrayView<float> OutValues)
+	{
+		const int32 Num = DistSq.Num();
+		check(OutValues.Num() >= Num);
+
+		const float InvRadius = Radius > 0 ? 1.0f / Radius : 0.0f;
+
+		const VectorRegister4Float VInvRadius = VectorSetFloat1(InvRadius);
+		const VectorRegister4Float VValue = VectorSetFloat1(Value);
+		const VectorRegister4Float VSlope = VectorSetFloat1(MinScale - 1.0f);
+		const VectorRegister4Float VOne = VectorOneFloat();
+
+		int32 Index = 0;
+		for (; Index + Lanes <= Num; Index += Lanes)
+		{
+			const VectorRegister4Float Alpha = VectorMin(
+				VectorMultiply(VectorSqrt(VectorLoad(&DistSq[Index])), VInvRadius),
+				VOne);
+			const VectorRegister4Float Scale = VectorMultiplyAdd(VSlope, Alpha, VOne);
+			VectorStore(VectorMultiply(VValue, Scale), &OutValues[Index]);
+		}
+
+		for (; Index < Num; Index++)
+		{
+			const float Alpha = FMath::Min(FMath::Sqrt(DistSq[Index]) * InvRadius, 1.0f);
+			OutValues[Index] = Value * ((MinScale - 1.0f) * Alpha + 1.0f);
+		}
+	}
+
+	void LaunchDirections(const FPositionsSoA& Positions, const FVector& Origin, FPositionsSoA& OutDirections)
+	{
+		const int32 Num = Positions.Num();
+		OutDirections.SetNum(Num);
+
+		//Origin is double precision, positions are float, both paths work from the same float copy
+		const FVector3f Origin3f(Origin);
+		const VectorRegister4Float OriginX = VectorSetFloat1(Origin3f.X);
+		const VectorRegister4Float OriginY = VectorSetFloat1(Origin3f.Y);
+		const VectorRegister4Float OriginZ = VectorSetFloat1(Origin3f.Z);
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		const VectorRegister4Float Tiny = VectorSetFloat1(UE_SMALL_NUMBER);
+
+		int32 Index = 0;
+		for (; Index + Lanes <= Num; Index += Lanes)
+		{
+			const VectorRegister4Float DX = VectorSubtract(VectorLoad(&Positions.X[Index]), OriginX);
+			const VectorRegister4Float DY = VectorSubtract(VectorLoad(&Positions.Y[Index]), OriginY);
+			const VectorRegister4Float DZ = VectorMin(VectorSubtract(VectorLoad(&Positions.Z[Index]), OriginZ), Zero);
+
+			VectorRegister4Float LengthSq = VectorMultiply(DX, DX);
+			LengthSq = VectorMultiplyAdd(DY, DY, LengthSq);
+			LengthSq = VectorMultiplyAdd(DZ, DZ, LengthSq);
+
+			//Like FVector::Normalize, too-short vectors are left alone
+			const VectorRegister4Float CanNormalize = VectorCompareGT(LengthSq, Tiny);
+			const VectorRegister4Float InvLength = VectorDivide(VectorOneFloat(), VectorSqrt(LengthSq));
+
+			VectorStore(VectorSelect(CanNormalize, VectorMultiply(DX, InvLength), DX), &OutDirections.X[Index]);
+			VectorStore(VectorSelect(CanNormalize, VectorMultiply(DY, InvLength), DY), &OutDirections.Y[Index]);
+			VectorStore(VectorSelect(CanNormalize, VectorMultiply(DZ, InvLength), DZ), &OutDirections.Z[Index]);
+		}
+
+		for (; Index < Num; Index++)
+		{
+			FVector3f Direction(
+				Positions.X[Index] - Origin3f.X,
+				Positions.Y[Index] - Origin3f.Y,
+				FMath::Min(Positions.Z[Index] - Origin3f.Z, 0.0f));
+			Direction.Normalize();
+
+			OutDirections.X[Index] = Direction.X;
+			OutDirections.Y[Index] = Direction.Y;
+			OutDirections.Z[Index] = Direction.Z;
+		}
+	}
+
+	void ConeDirections(
+		const FVector& Axis,
+		const float HalfAngleRadians,
+		const int32 Count,
+		FRandomStream& Stream,
+		FPositionsSoA& OutDirections)
+	{
+		TArray<float> U1;
+		TArray<float> U2;
+		DrawConeSamples(Count, Stream, U1, U2);
+
+		OutDirections.SetNum(Count);
+
+		FVector AxisX = Axis.GetSafeNormal();
+		FVector AxisY;
+		FVector AxisZ;
+		AxisX.FindBestAxisVectors(AxisY, AxisZ);
+
+		const VectorRegister4Float TwoPi = VectorSetFloat1(UE_TWO_PI);
+		const VectorRegister4Float OneMinusCos = VectorSetFloat1(1.0f - FMath::Cos(HalfAngleRadians));
+		const VectorRegister4Float One = VectorOneFloat();
+
+		int32 Index = 0;
+		for (; Index + Lanes <= Count; Index += Lanes)
+		{
+			//Uniform over the spherical cap
+			const VectorRegister4Float CosPhi = VectorSubtract(One, VectorMultiply(VectorLoad(&U2[Index]), OneMinusCos));
+			const VectorRegister4Float SinPhi = VectorSqrt(VectorMax(
+				VectorSubtract(One, VectorMultiply(CosPhi, CosPhi)),
+				VectorZeroFloat()));
+
+			const VectorRegister4Float Theta = VectorMultiply(VectorLoad(&U1[Index]), TwoPi);
+			VectorRegister4Float SinTheta;
+			VectorRegister4Float CosTheta;
+			VectorSinCos(&SinTheta, &CosTheta, &Theta);
+
+			const VectorRegister4Float LocalY = VectorMultiply(CosTheta, SinPhi);
+			const VectorRegister4Float LocalZ = VectorMultiply(SinTheta, SinPhi);
+
+			//Rotate into the axis basis, one component array at a time
+			auto Basis = [&](const float X, const float Y, const float Z, float* Out)
+			{
+				VectorRegister4Float Result = VectorMultiply(CosPhi, VectorSetFloat1(X));
+				Result = VectorMultiplyAdd(LocalY, VectorSetFloat1(Y), Result);
+				Result = VectorMultiplyAdd(LocalZ, VectorSetFloat1(Z), Result);
+				VectorStore(Result, Out);
+			};
+			Basis(AxisX.X, AxisY.X, AxisZ.X, &OutDirections.X[Index]);
+			Basis(AxisX.Y, AxisY.Y, AxisZ.Y, &OutDirections.Y[Index]);
+			Basis(AxisX.Z, AxisY.Z, AxisZ.Z, &OutDirections.Z[Index]);
+		}
+
+		for (; Index < Count; Index++)
+		{
+			const float CosPhi = 1.0f - U2[Index] * (1.0f - FMath::Cos(HalfAngleRadians));
+			const float SinPhi = FMath::Sqrt(FMath::Max(1.0f - CosPhi * CosPhi, 0.0f));
+
+			float SinTheta;
+			float CosTheta;
+			FMath::SinCos(&SinTheta, &CosTheta, U1[Index] * UE_TWO_PI);
+
+			const FVector Direction = AxisX * CosPhi + AxisY * (CosTheta * SinPhi) + AxisZ * (SinTheta * SinPhi);
+			OutDirections.X[Index] = Direction.X;
+			OutDirections.Y[Index] = Direction.Y;
+			OutDirections.Z[Index] = Direction.Z;
+		}
+	}
+
+	namespace Scalar
+	{
+		void DistanceSquared(const FPositionsSoA& Positions, const FVector& Origin, const TArrayView<float> OutDistSq)
+		{
+			check(OutDistSq.Num() >= Positions.Num());
+
+			for (int32 Index = 0; Index < Positions.Num(); Index++)
+			{
+				OutDistSq[Index] = FVector3f::DistSquared(FVector3f(Positions.Get(Index)), FVector3f(Origin));
+			}
+		}
+
+		void FilterRadius(
+			const FPositionsSoA& Positions,
+			const FVector& Origin,
+			const float Radius,
+			TArray<int32>& OutIndices)
+		{
+			OutIndices.Reset();
+
+			const float RadiusSq = FMath::Square(Radius);
+			for (int32 Index = 0; Index < Positions.Num(); Index++)
+			{
+				if (FVector3f::DistSquared(FVector3f(Positions.Get(Index)), FVector3f(Origin)) <= RadiusSq)
+				{
+					OutIndices.Add(Index);
+				}
+			}
+		}
+
+		void NearestK(
+			const FPositionsSoA& Positions,
+			const FVector& Origin,
+			const int32 K,
+			const float MaxDistance,
+			TArray<int32>& OutIndices)
+		{
+			TArray<float, TInlineAllocator<256>> DistSq;
+			DistSq.SetNumUninitialized(Positions.Num());
+			DistanceSquared(Positions, Origin, DistSq);
+
+			SelectNearest(DistSq, K, MaxDistance, OutIndices);
+		}
+
+		void Falloff(
+			const TConstArrayView<float> DistSq,
+			const float Radius,
+			const float Value,
+			const float MinScale,
+			const TArrayView<float> OutValues)
+		{
+			check(OutValues.Num() >= DistSq.Num());
+
+			for (int32 Index = 0; Index < DistSq.Num(); Index++)
+			{
+				const float Alpha = Radius > 0 ? FMath::Min(FMath::Sqrt(DistSq[Index]) / Radius, 1.0f) : 0.0f;
+				OutValues[Index] = Value * FMath::Lerp(1.0f, MinScale, Alpha);
+			}
+		}
+
+		void LaunchDirections(const FPositionsSoA& Positions, const FVector& Origin, FPositionsSoA& OutDirections)
+		{
+			OutDirections.Reset(Positions.Num());
+
+			for (int32 Index = 0; Index < Positions.Num(); Index++)
+			{
+				FVector3f Direction = FVector3f(Positions.Get(Index)) - FVector3f(Origin);
+				if (Direction.Z > 0)
+				{
+					Direction.Z = 0;
+				}
+				Direction.Normalize();
+
+				OutDirections.Add(FVector(Direction));
+			}
+		}
+
+		void ConeDirections(
+			const FVector& Axis,
+			const float HalfAngleRadians,
+			const int32 Count,
+			FRandomStream& Stream,
+			FPositionsSoA& OutDirections)
+		{
+			TArray<float> U1;
+			TArray<float> U2;
+			DrawConeSamples(Count, Stream, U1, U2);
+
+			OutDirections.Reset(Count);
+
+			FVector AxisX = Axis.GetSafeNormal();
+			FVector AxisY;
+			FVector AxisZ;
+			AxisX.FindBestAxisVectors(AxisY, AxisZ);
+
+			for (int32 Index = 0; Index < Count; Index++)
+			{
+				const float CosPhi = 1.0f - U2[Index] * (1.0f - FMath::Cos(HalfAngleRadians));
+				const float SinPhi = FMath::Sqrt(FMath::Max(1.0f - CosPhi * CosPhi, 0.0f));
+				const float Theta = U1[Index] * UE_TWO_PI;
+
+				OutDirections.Add(
+					AxisX * CosPhi +
+					AxisY * (FMath::Cos(Theta) * SinPhi) +
+					AxisZ * (FMath::Sin(Theta) * SinPhi));
+			}
+		}
+	}
+}
@@ -0,0 +1,99 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Batched combat math over struct-of-arrays positions. Each kernel runs four candidates per SIMD
+//register and has a scalar reference in Y25::CombatMath::Scalar that gives the same results.
+namespace Y25::CombatMath
+{
+	struct Y25_API FPositionsSoA
+	{
+		TArray<float> X;
+		TArray<float> Y;
+		TArray<float> Z;
+
+		void Reset(int32 Capacity = 0);
+
+		void SetNum(int32 Num);
+
+		int32 Add(const FVector& Position);
+
+		int32 Num() const;
+
+		FVector Get(int32 Index) const;
+	};
+
+	//Squared distance from Origin to every position
+	Y25_API void DistanceSquared(const FPositionsSoA& Positions, const FVector& Origin, TArrayView<float> OutDistSq);
+
+	//Indices of every position within Radius of Origin, in input order
+	Y25_API void FilterRadius(
+		const FPositionsSoA& Positions,
+		const FVector& Origin,
+		float Radius,
+		TArray<int32>& OutIndices);
+
+	//Up to K indices within MaxDistance of Origin, closest first
+	Y25_API void NearestK(
+		const FPositionsSoA& Positions,
+		const FVector& Origin,
+		int32 K,
+		float MaxDistance,
+		TArray<int32>& OutIndices);
+
+	//Value scaled linearly from 1 at the center down to MinScale at Radius
+	Y25_API void Falloff(
+		TConstArrayView<float> DistSq,
+		float Radius,
+		float Value,
+		float MinScale,
+		TArrayView<float> OutValues);
+
+	//Normalized knockback direction away from Origin, never launching upwards
+	Y25_API void LaunchDirections(const FPositionsSoA& Positions, const FVector& Origin, FPositionsSoA& OutDirections);
+
+	//Count random unit directions inside a cone around Axis
+	Y25_API void ConeDirections(
+		const FVector& Axis,
+		float HalfAngleRadians,
+		int32 Count,
+		FRandomStream& Stream,
+		FPositionsSoA& OutDirections);
+
+	//Reference implementations
+	namespace Scalar
+	{
+		Y25_API void DistanceSquared(const FPositionsSoA& Positions, const FVector& Origin, TArrayView<float> OutDistSq);
+
+		Y25_API void FilterRadius(
+			const FPositionsSoA& Positions,
+			const FVector& Origin,
+			float Radius,
+			TArray<int32>& OutIndices);
+
+		Y25_API void NearestK(
+			const FPositionsSoA& Positions,
+			const FVector& Origin,
+			int32 K,
+			float MaxDistance,
+			TArray<int32>& OutIndices);
+
+		Y25_API void Falloff(
+			TConstArrayView<float> DistSq,
+			float Radius,
+			float Value,
+			float MinScale,
+			TArrayView<float> OutValues);
+
+		Y25_API void LaunchDirections(const FPositionsSoA& Positions, const FVector& Origin, FPositionsSoA& OutDirections);
+
+		Y25_API void ConeDirections(
+			const FVector& Axis,
+			float HalfAngleRadians,
+			int32 Count,
+			FRandomStream& Stream,
+			FPositionsSoA& OutDirections);
+	}
+}
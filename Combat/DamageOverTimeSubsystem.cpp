@@ -0,0 +1,171 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "DamageOverTimeSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "Kismet/GameplayStatics.h"
+#include "Y25/Enemies/BaseEnemy.h"
+#include "Y25/Player/MainPlayerController.h"
+
+bool UDamageOverTimeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDamageOverTimeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//A zero interval would never finish catching up
+	DamageInterval = FMath::Max(DamageInterval, MinDamageInterval);
+	MaxPassesPerFrame = FMath::Max(MaxPassesPerFrame, 1);
+}
+
+void UDamageOverTimeSubsystem::Deinitialize()
+{
+	Targets.Empty();
+	RemainingTimes.Empty();
+	DamagePerTicks.Empty();
+	SourcePlayers.Empty();
+	DamageCausers.Empty();
+	Keys.Empty();
+	EffectIndices.Empty();
+	DamageTicks.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UDamageOverTimeSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageOverTimeSubsystem, STATGROUP_Tickables);
+}
+
+int32 UDamageOverTimeSubsystem::GetNumEffects() const
+{
+	return Targets.Num();
+}
+
+void UDamageOverTimeSubsystem::Apply(
+	AActor* Target,
+	const float DamagePerSecond,
+	const float Duration,
+	AMainPlayerController* SourcePlayer,
+	AActor* DamageCauser)
+{
+	if (!Target || DamagePerSecond <= 0 || Duration <= 0)
+	{
+		return;
+	}
+
+	const float DamagePerTick = DamagePerSecond * DamageInterval;
+
+	//Refresh, keeping whichever is longer and stronger
+	const FEffectKey Key(Target, SourcePlayer);
+	if (const int32* Existing = EffectIndices.Find(Key))
+	{
+		RemainingTimes[*Existing] = FMath::Max(RemainingTimes[*Existing], Duration);
+		DamagePerTicks[*Existing] = FMath::Max(DamagePerTicks[*Existing], DamagePerTick);
+		DamageCausers[*Existing] = DamageCauser;
+		return;
+	}
+
+	EffectIndices.Add(Key, Targets.Num());
+	Targets.Add(Target);
+	RemainingTimes.Add(Duration);
+	DamagePerTicks.Add(DamagePerTick);
+	SourcePlayers.Add(SourcePlayer);
+	DamageCausers.Add(DamageCauser);
+	Keys.Add(Key);
+}
+
+void UDamageOverTimeSubsystem::RemoveAt(const int32 Index)
+{
+	EffectIndices.Remove(Keys[Index]);
+
+	const int32 Last = Targets.Num() - 1;
+	if (Index != Last)
+	{
+		EffectIndices[Keys[Last]] = Index;
+	}
+
+	Targets.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	RemainingTimes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	DamagePerTicks.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	SourcePlayers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	DamageCausers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Keys.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+void UDamageOverTimeSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Targets.IsEmpty())
+	{
+		TimeSinceDamage = 0;
+		return;
+	}
+
+	//Fixed rate no matter the frame rate, but a hitch only catches up a few passes
+	TimeSinceDamage += DeltaTime;
+	for (int32 Pass = 0; Pass < MaxPassesPerFrame && TimeSinceDamage >= DamageInterval; Pass++)
+	{
+		TimeSinceDamage -= DamageInterval;
+		DealDamage();
+	}
+	TimeSinceDamage = FMath::Min(TimeSinceDamage, DamageInterval);
+}
+
+void UDamageOverTimeSubsystem::DealDamage()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UDamageOverTimeSubsystem::DealDamage);
+
+	//Count down every effect and collect this pass's damage
+	DamageTicks.Reset();
+	for (int32 Index = Targets.Num() - 1; Index >= 0; Index--)
+	{
+		const ABaseEnemy* Enemy = Cast<ABaseEnemy>(Targets[Index].Get());
+		if (!Enemy || Enemy->IsDead())
+		{
+			RemoveAt(Index);
+			continue;
+		}
+
+		DamageTicks.Add({Targets[Index], DamagePerTicks[Index], SourcePlayers[Index], DamageCausers[Index]});
+
+		RemainingTimes[Index] -= DamageInterval;
+		if (RemainingTimes[Index] <= 0)
+		{
+			RemoveAt(Index);
+		}
+	}
+
+	for (const FDamageTick& DamageTick : DamageTicks)
+	{
+		ABaseEnemy* Enemy = Cast<ABaseEnemy>(DamageTick.Target.Get());
+		if (!Enemy || Enemy->IsDead())
+		{
+			continue;
+		}
+
+		AMainPlayerController* SourcePlayer = DamageTick.SourcePlayer.Get();
+
+		UGameplayStatics::ApplyDamage(
+			Enemy,
+			DamageTick.Damage,
+			SourcePlayer,
+			DamageTick.DamageCauser.Get(),
+			UDamageType::StaticClass());
+
+		// add to bots killed
+		if (AControlPlayerState* PlayerState =
+				SourcePlayer ? SourcePlayer->GetPlayerState<AControlPlayerState>() : nullptr;
+			Enemy->Health->GetHealth() <= 0 && PlayerState)
+		{
+			PlayerState->PlayerEndStats.FindOrAdd(TEXT("Bot Kills"))++;
+			PlayerState->PlayerTrueStats.FindOrAdd(TEXT("Bot Kills"))++;
+			PlayerState->UpdateScore();
+		}
+	}
+}
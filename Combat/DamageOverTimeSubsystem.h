@@ -0,0 +1,78 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "DamageOverTimeSubsystem.generated.h"
+
+class AMainPlayerController;
+
+//Lingering damage on enemies without a gameplay effect or timer per target. Active effects live in parallel arrays
+//and all of them deal their damage together at a fixed rate.
+UCLASS(Config=Game)
+class Y25_API UDamageOverTimeSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Damage Target for Duration seconds. The same player applying again refreshes the effect instead of stacking.
+	void Apply(
+		AActor* Target,
+		float DamagePerSecond,
+		float Duration,
+		AMainPlayerController* SourcePlayer,
+		AActor* DamageCauser);
+
+	int32 GetNumEffects() const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	using FEffectKey = TPair<TObjectKey<AActor>, TObjectKey<AMainPlayerController>>;
+
+	//Seconds between damage passes, never below MinDamageInterval
+	UPROPERTY(Config)
+	float DamageInterval = 0.25f;
+
+	//Most damage passes a long frame can catch up on, the rest of the backlog is dropped
+	UPROPERTY(Config)
+	int32 MaxPassesPerFrame = 4;
+
+	static constexpr float MinDamageInterval = 0.01f;
+
+	void DealDamage();
+
+	void RemoveAt(int32 Index);
+
+	//Active effects, one entry per array
+	TArray<TWeakObjectPtr<AActor>> Targets;
+	TArray<float> RemainingTimes;
+	TArray<float> DamagePerTicks;
+	TArray<TWeakObjectPtr<AMainPlayerController>> SourcePlayers;
+	TArray<TWeakObjectPtr<AActor>> DamageCausers;
+	TArray<FEffectKey> Keys;
+
+	TMap<FEffectKey, int32> EffectIndices;
+
+	float TimeSinceDamage = 0;
+
+	//Damage dealt this pass, applied once the arrays are settled so new effects can be added from damage events
+	struct FDamageTick
+	{
+		TWeakObjectPtr<AActor> Target;
+		float Damage;
+		TWeakObjectPtr<AMainPlayerController> SourcePlayer;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+	TArray<FDamageTick> DamageTicks;
+};
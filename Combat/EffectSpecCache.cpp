@@ -0,0 +1,92 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "EffectSpecCache.h"
+
+#include "AbilitySystemComponent.h"
+#include "GameplayEffect.h"
+#include "Y25/Gameplay/Tags.h"
+
+//Entries past this are checked for dead targets and sources before another is added
+static constexpr int32 MaxCachedSpecs = 256;
+
+FActiveGameplayEffectHandle FEffectSpecCache::Apply(
+	const TSubclassOf<UGameplayEffect> EffectClass,
+	UAbilitySystemComponent* Target,
+	UObject* SourceObject,
+	const float Damage)
+{
+	if (!EffectClass || !Target)
+	{
+		return FActiveGameplayEffectHandle();
+	}
+
+	bool* bCacheable = Cacheable.Find(EffectClass);
+	if (!bCacheable)
+	{
+		bCacheable = &Cacheable.Add(
+			EffectClass,
+			!HasSnapshottedSourceCaptures(*EffectClass->GetDefaultObject<UGameplayEffect>()));
+	}
+
+	const FKey Key(Target, EffectClass, SourceObject);
+	FGameplayEffectSpecHandle SpecHandle = *bCacheable ? Specs.FindRef(Key) : FGameplayEffectSpecHandle();
+	if (!SpecHandle.IsValid())
+	{
+		FGameplayEffectContextHandle EffectContextHandle = Target->MakeEffectContext();
+		EffectContextHandle.AddSourceObject(SourceObject);
+
+		SpecHandle = Target->MakeOutgoingSpec(EffectClass, 1.f, EffectContextHandle);
+		if (!SpecHandle.IsValid())
+		{
+			return FActiveGameplayEffectHandle();
+		}
+
+		if (*bCacheable)
+		{
+			if (Specs.Num() >= MaxCachedSpecs)
+			{
+				for (auto It = Specs.CreateIterator(); It; ++It)
+				{
+					if (!It.Key().Get<0>().ResolveObjectPtr() || !It.Key().Get<2>().ResolveObjectPtr())
+					{
+						It.RemoveCurrent();
+					}
+				}
+			}
+			Specs.Add(Key, SpecHandle);
+		}
+	}
+
+	SpecHandle.Data->SetSetByCallerMagnitude(Y25::Tags::GameplayEffect_Health_Damaged, Damage);
+	return Target->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
+}
+
+void FEffectSpecCache::Reset()
+{
+	Specs.Empty();
+	Cacheable.Empty();
+}
+
+int32 FEffectSpecCache::Num() const
+{
+	return Specs.Num();
+}
+
+bool FEffectSpecCache::HasSnapshottedSourceCaptures(const UGameplayEffect& Effect)
+{
+	TArray<FGameplayEffectAttributeCaptureDefinition> Captures;
+	Effect.DurationMagnitude.GetAttributeCaptureDefinitions(Captures);
+	for (const FGameplayModifierInfo& Modifier : Effect.Modifiers)
+	{
+		Modifier.ModifierMagnitude.GetAttributeCaptureDefinitions(Captures);
+	}
+	for (const FGameplayEffectExecutionDefinition& Execution : Effect.Executions)
+	{
+		Execution.GetAttributeCaptureDefinitions(Captures);
+	}
+
+	return Captures.ContainsByPredicate([](const FGameplayEffectAttributeCaptureDefinition& Capture)
+	{
+		return Capture.AttributeSource == EGameplayEffectAttributeCaptureSource::Source && Capture.bSnapshot;
+	});
+}
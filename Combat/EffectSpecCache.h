@@ -0,0 +1,38 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "GameplayEffectTypes.h"
+#include "Templates/SubclassOf.h"
+#include "UObject/ObjectKey.h"
+
+class UAbilitySystemComponent;
+class UGameplayEffect;
+
+//Outgoing gameplay effect specs kept per target, effect class and source object, so repeat hits only patch the damage.
+//Specs are made by the target's own ability system like a fresh one would be. Effects that snapshot source attributes
+//are never cached, a reused spec would keep the first capture forever.
+struct Y25_API FEffectSpecCache
+{
+	//Apply EffectClass to Target credited to SourceObject, Damage is the health damage set-by-caller
+	FActiveGameplayEffectHandle Apply(
+		TSubclassOf<UGameplayEffect> EffectClass,
+		UAbilitySystemComponent* Target,
+		UObject* SourceObject,
+		float Damage = 0);
+
+	void Reset();
+
+	int32 Num() const;
+
+	//Any modifier, execution or duration that snapshots a source attribute
+	static bool HasSnapshottedSourceCaptures(const UGameplayEffect& Effect);
+
+private:
+	using FKey = TTuple<TObjectKey<UAbilitySystemComponent>, TSubclassOf<UGameplayEffect>, TObjectKey<UObject>>;
+
+	TMap<FKey, FGameplayEffectSpecHandle> Specs;
+
+	//Whether each effect class passed HasSnapshottedSourceCaptures
+	TMap<TSubclassOf<UGameplayEffect>, bool> Cacheable;
+};
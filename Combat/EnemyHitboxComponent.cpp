@@ -0,0 +1,172 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "EnemyHitboxComponent.h"
+
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "Y25/Enemies/BaseEnemy.h"
+#include "Y25/Values/Collision.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogEnemyHitbox, Log, All);
+
+UEnemyHitboxComponent::UEnemyHitboxComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void UEnemyHitboxComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SetComponentTickInterval(UpdateInterval);
+
+	if (const ACharacter* Character = Cast<ACharacter>(GetOwner()))
+	{
+		Mesh = Character->GetMesh();
+	}
+
+	if (!Mesh)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	CreateProxies();
+	UpdateProxies();
+}
+
+void UEnemyHitboxComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (UCapsuleComponent* Proxy : Proxies)
+	{
+		if (Proxy)
+		{
+			Proxy->DestroyComponent();
+		}
+	}
+	Proxies.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UEnemyHitboxComponent::CreateProxies()
+{
+	//Without proxies there would be nothing left for weapon traces to hit
+	if (Hitboxes.IsEmpty())
+	{
+		UE_LOG(LogEnemyHitbox, Warning, TEXT("%s has no hitboxes, keeping its own collision"), *GetOwner()->GetName());
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	//Weapon traces stop seeing the mesh bodies and the movement capsule
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(GetOwner());
+	for (UPrimitiveComponent* Primitive : Primitives)
+	{
+		Primitive->SetCollisionResponseToChannel(Y25::Collision::Channels::Weapon, ECR_Ignore);
+	}
+
+	BoneIndices.Reset(Hitboxes.Num());
+	Proxies.Reset(Hitboxes.Num());
+
+	for (const FEnemyHitbox& Hitbox : Hitboxes)
+	{
+		BoneIndices.Add(Mesh->GetBoneIndex(Hitbox.Bone));
+
+		//Query only, pawn typed so piercing traces can still overlap it
+		UCapsuleComponent* Proxy = NewObject<UCapsuleComponent>(GetOwner(), NAME_None, RF_Transient);
+		Proxy->SetupAttachment(this);
+		Proxy->SetUsingAbsoluteLocation(true);
+		Proxy->SetUsingAbsoluteRotation(true);
+		Proxy->SetCapsuleSize(Hitbox.Radius, Hitbox.HalfHeight);
+		Proxy->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		Proxy->SetCollisionObjectType(Y25::Collision::Channels::Pawn);
+		Proxy->SetCollisionResponseToAllChannels(ECR_Ignore);
+		Proxy->SetCollisionResponseToChannel(Y25::Collision::Channels::Weapon, ECR_Block);
+		Proxy->SetGenerateOverlapEvents(false);
+		Proxy->SetCanEverAffectNavigation(false);
+		Proxy->SetHiddenInGame(true);
+		Proxy->RegisterComponent();
+
+		Proxies.Add(Proxy);
+	}
+}
+
+void UEnemyHitboxComponent::TickComponent(
+	const float DeltaTime,
+	const ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//Dead enemies would keep stopping shots meant for whatever is behind them
+	if (const ABaseEnemy* Enemy = Cast<ABaseEnemy>(GetOwner()); Enemy && Enemy->IsDead())
+	{
+		SetProxiesEnabled(false);
+		return;
+	}
+
+	UpdateProxies();
+}
+
+void UEnemyHitboxComponent::SetProxiesEnabled(const bool bEnabled)
+{
+	if (Proxies.IsEmpty())
+	{
+		return;
+	}
+
+	for (UCapsuleComponent* Proxy : Proxies)
+	{
+		Proxy->SetCollisionEnabled(bEnabled ? ECollisionEnabled::QueryOnly : ECollisionEnabled::NoCollision);
+	}
+
+	SetComponentTickEnabled(bEnabled);
+	if (bEnabled)
+	{
+		UpdateProxies();
+	}
+}
+
+void UEnemyHitboxComponent::UpdateProxies() const
+{
+	for (int32 Index = 0; Index < Proxies.Num(); Index++)
+	{
+		if (BoneIndices[Index] == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FTransform Transform = Hitboxes[Index].Offset * Mesh->GetBoneTransform(BoneIndices[Index]);
+		Proxies[Index]->SetWorldLocationAndRotation(
+			Transform.GetLocation(),
+			Transform.GetRotation(),
+			false,
+			nullptr,
+			ETeleportType::TeleportPhysics);
+	}
+}
+
+FName UEnemyHitboxComponent::GetHitBone(const FHitResult& HitResult)
+{
+	if (!HitResult.BoneName.IsNone())
+	{
+		return HitResult.BoneName;
+	}
+
+	//Proxies are attached to the hitbox component in hitbox order
+	const UPrimitiveComponent* HitComponent = HitResult.GetComponent();
+	if (const UEnemyHitboxComponent* HitboxComponent =
+		HitComponent ? Cast<UEnemyHitboxComponent>(HitComponent->GetAttachParent()) : nullptr)
+	{
+		if (const int32 Index = HitboxComponent->Proxies.IndexOfByKey(HitComponent); Index != INDEX_NONE)
+		{
+			return HitboxComponent->Hitboxes[Index].Bone;
+		}
+	}
+
+	return NAME_None;
+}
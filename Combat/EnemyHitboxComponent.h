@@ -0,0 +1,79 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Components/SceneComponent.h"
+
+#include "EnemyHitboxComponent.generated.h"
+
+class UCapsuleComponent;
+class USkeletalMeshComponent;
+
+USTRUCT(BlueprintType)
+struct FEnemyHitbox
+{
+	GENERATED_BODY()
+
+	//Bone on the owner's mesh the capsule follows
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox")
+	FName Bone;
+
+	//Relative to the bone, the capsule runs along its local Z
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox")
+	FTransform Offset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox", meta = (ClampMin = 0))
+	float Radius = 20;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox", meta = (ClampMin = 0))
+	float HalfHeight = 40;
+};
+
+//Replaces an enemy's mesh and capsule with a few simple capsules for weapon traces. The capsules are the only
+//thing on the enemy that responds to the weapon channel, and they follow their bones at a reduced rate until the
+//enemy dies.
+UCLASS(ClassGroup = (Y25), meta = (BlueprintSpawnableComponent))
+class Y25_API UEnemyHitboxComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyHitboxComponent();
+
+	virtual void TickComponent(
+		float DeltaTime,
+		ELevelTick TickType,
+		FActorComponentTickFunction* ThisTickFunction) override;
+
+	//Bone a weapon hit landed on, works for both proxy and mesh hits
+	static FName GetHitBone(const FHitResult& HitResult);
+
+	//Turn the capsules off or back on, they turn themselves off when the enemy dies
+	UFUNCTION(BlueprintCallable, Category = "Hitbox")
+	void SetProxiesEnabled(bool bEnabled);
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox")
+	TArray<FEnemyHitbox> Hitboxes;
+
+	//Seconds between capsule updates
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hitbox", meta = (ClampMin = 0))
+	float UpdateInterval = 0.05f;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void CreateProxies();
+
+	void UpdateProxies() const;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> Mesh;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCapsuleComponent>> Proxies;
+
+	TArray<int32> BoneIndices;
+};
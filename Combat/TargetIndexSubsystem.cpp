@@ -0,0 +1,330 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "TargetIndexSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Y25/Enemies/BaseEnemy.h"
+#include "Y25/Player/MainCharacter.h"
+
+void UTargetIndexSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Pick up every enemy and player as they spawn
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(
+		FOnActorSpawned::FDelegate::CreateUObject(this, &ThisClass::HandleActorSpawned));
+}
+
+void UTargetIndexSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	Entries.Empty();
+	Cells.Empty();
+	EntryLookup.Empty();
+
+	Super::Deinitialize();
+}
+
+void UTargetIndexSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Anything placed in the level
+	for (TActorIterator<APawn> It(&InWorld); It; ++It)
+	{
+		Register(*It);
+	}
+}
+
+bool UTargetIndexSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UTargetIndexSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTargetIndexSubsystem, STATGROUP_Tickables);
+}
+
+void UTargetIndexSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	//Move entries between cells as they walk around
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		FTargetEntry& Entry = *It;
+
+		const APawn* Pawn = Entry.Pawn.Get();
+		if (!Pawn)
+		{
+			RemoveAt(It.GetIndex());
+			continue;
+		}
+
+		Entry.Location = Pawn->GetActorLocation();
+
+		if (const FIntPoint NewCell = GetCell(Entry.Location); NewCell != Entry.Cell)
+		{
+			if (TArray<int32>* OldCell = Cells.Find(Entry.Cell))
+			{
+				OldCell->RemoveSwap(It.GetIndex(), EAllowShrinking::No);
+			}
+			Cells.FindOrAdd(NewCell).Add(It.GetIndex());
+			Entry.Cell = NewCell;
+		}
+	}
+}
+
+void UTargetIndexSubsystem::Register(APawn* Pawn)
+{
+	const ETargetKind Kind = GetTargetKind(Pawn);
+	if (Kind == ETargetKind::None || EntryLookup.Contains(Pawn))
+	{
+		return;
+	}
+
+	FTargetEntry Entry;
+	Entry.Pawn = Pawn;
+	Entry.Key = Pawn;
+	Entry.Location = Pawn->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+	Entry.Kind = Kind;
+
+	const int32 EntryIndex = Entries.Add(Entry);
+	Cells.FindOrAdd(Entry.Cell).Add(EntryIndex);
+	EntryLookup.Add(Pawn, EntryIndex);
+
+	Pawn->OnDestroyed.AddUniqueDynamic(this, &ThisClass::HandleActorDestroyed);
+}
+
+void UTargetIndexSubsystem::Unregister(APawn* Pawn)
+{
+	if (const int32* EntryIndex = EntryLookup.Find(Pawn))
+	{
+		RemoveAt(*EntryIndex);
+	}
+}
+
+void UTargetIndexSubsystem::RemoveAt(const int32 EntryIndex)
+{
+	const FTargetEntry& Entry = Entries[EntryIndex];
+
+	if (TArray<int32>* Cell = Cells.Find(Entry.Cell))
+	{
+		Cell->RemoveSwap(EntryIndex, EAllowShrinking::No);
+	}
+
+	EntryLookup.Remove(Entry.Key);
+	Entries.RemoveAt(EntryIndex);
+}
+
+void UTargetIndexSubsystem::HandleActorSpawned(AActor* SpawnedActor)
+{
+	if (APawn* Pawn = Cast<APawn>(SpawnedActor))
+	{
+		Register(Pawn);
+	}
+}
+
+void UTargetIndexSubsystem::HandleActorDestroyed(AActor* DestroyedActor)
+{
+	Unregister(Cast<APawn>(DestroyedActor));
+}
+
+ETargetKind UTargetIndexSubsystem::GetTargetKind(const AActor* Actor)
+{
+	if (!Actor)
+	{
+		return ETargetKind::None;
+	}
+	if (Actor->IsA(ABaseEnemy::StaticClass()))
+	{
+		return ETargetKind::Enemy;
+	}
+	if (Actor->IsA(AMainCharacter::StaticClass()))
+	{
+		return ETargetKind::Player;
+	}
+	return ETargetKind::None;
+}
+
+bool UTargetIndexSubsystem::IsAlive(const FTargetEntry& Entry)
+{
+	APawn* Pawn = Entry.Pawn.Get();
+	if (!Pawn)
+	{
+		return false;
+	}
+
+	//Kind was checked on register, no cast needed
+	if (Entry.Kind == ETargetKind::Enemy)
+	{
+		return !static_cast<ABaseEnemy*>(Pawn)->IsDead();
+	}
+	return !static_cast<AMainCharacter*>(Pawn)->GetIsDead();
+}
+
+FIntPoint UTargetIndexSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(
+		FMath::FloorToInt32(Location.X / CellSize),
+		FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+template <typename FunctorType>
+void UTargetIndexSubsystem::ForEachInRange(
+	const FVector& Location,
+	const float Range,
+	const ETargetKind Kinds,
+	FunctorType&& Visitor) const
+{
+	const FIntPoint MinCell = GetCell(Location - FVector(Range));
+	const FIntPoint MaxCell = GetCell(Location + FVector(Range));
+	const int64 NumCells = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1);
+
+	//Long range queries touch more cells than there are targets, just walk the entries
+	if (NumCells > Entries.Num())
+	{
+		for (const FTargetEntry& Entry : Entries)
+		{
+			if (EnumHasAnyFlags(Kinds, Entry.Kind) && IsAlive(Entry))
+			{
+				Visitor(Entry);
+			}
+		}
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<int32>* Cell = Cells.Find(FIntPoint(X, Y));
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (const int32 EntryIndex : *Cell)
+			{
+				const FTargetEntry& Entry = Entries[EntryIndex];
+				if (EnumHasAnyFlags(Kinds, Entry.Kind) && IsAlive(Entry))
+				{
+					Visitor(Entry);
+				}
+			}
+		}
+	}
+}
+
+void UTargetIndexSubsystem::QueryRadius(
+	const FVector& Location,
+	const float Radius,
+	TArray<APawn*>& OutTargets,
+	const ETargetKind Kinds) const
+{
+	OutTargets.Reset();
+
+	const double RadiusSq = FMath::Square(Radius);
+	ForEachInRange(Location, Radius, Kinds, [&](const FTargetEntry& Entry)
+	{
+		if (FVector::DistSquared(Location, Entry.Location) <= RadiusSq)
+		{
+			OutTargets.Add(Entry.Pawn.Get());
+		}
+	});
+}
+
+void UTargetIndexSubsystem::QueryNearest(
+	const FVector& Location,
+	const float MaxDistance,
+	const int32 MaxResults,
+	TArray<APawn*>& OutTargets,
+	const ETargetKind Kinds,
+	const TSet<APawn*>* IgnoredTargets) const
+{
+	OutTargets.Reset();
+
+	TArray<TPair<double, APawn*>, TInlineAllocator<64>> Found;
+
+	const double MaxDistanceSq = FMath::Square(MaxDistance);
+	ForEachInRange(Location, MaxDistance, Kinds, [&](const FTargetEntry& Entry)
+	{
+		APawn* Pawn = Entry.Pawn.Get();
+		if (IgnoredTargets && IgnoredTargets->Contains(Pawn))
+		{
+			return;
+		}
+
+		if (const double DistSq = FVector::DistSquared(Location, Entry.Location); DistSq <= MaxDistanceSq)
+		{
+			Found.Emplace(DistSq, Pawn);
+		}
+	});
+
+	Found.Sort([](const TPair<double, APawn*>& A, const TPair<double, APawn*>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	for (int32 Index = 0; Index < Found.Num() && Index < MaxResults; Index++)
+	{
+		OutTargets.Add(Found[Index].Value);
+	}
+}
+
+void UTargetIndexSubsystem::QueryCone(
+	const FVector& Origin,
+	const FVector& Direction,
+	const float HalfAngleRadians,
+	const float MaxDistance,
+	TArray<APawn*>& OutTargets,
+	const ETargetKind Kinds) const
+{
+	OutTargets.Reset();
+
+	TArray<TPair<double, APawn*>, TInlineAllocator<64>> Found;
+
+	const FVector ConeDirection = Direction.GetSafeNormal();
+	const double CosHalfAngle = FMath::Cos(HalfAngleRadians);
+	const double MaxDistanceSq = FMath::Square(MaxDistance);
+
+	ForEachInRange(Origin, MaxDistance, Kinds, [&](const FTargetEntry& Entry)
+	{
+		const FVector ToTarget = Entry.Location - Origin;
+		const double DistSq = ToTarget.SizeSquared();
+		if (DistSq > MaxDistanceSq || DistSq <= UE_SMALL_NUMBER)
+		{
+			return;
+		}
+
+		//Compare against the cone without a square root on the rejected path
+		const double Along = FVector::DotProduct(ToTarget, ConeDirection);
+		if (Along > 0 && Along * Along >= CosHalfAngle * CosHalfAngle * DistSq)
+		{
+			Found.Emplace(DistSq, Entry.Pawn.Get());
+		}
+	});
+
+	Found.Sort([](const TPair<double, APawn*>& A, const TPair<double, APawn*>& B)
+	{
+		return A.Key < B.Key;
+	});
+
+	for (const TPair<double, APawn*>& Target : Found)
+	{
+		OutTargets.Add(Target.Value);
+	}
+}
+
+int32 UTargetIndexSubsystem::GetNumTargets() const
+{
+	return Entries.Num();
+}
@@ -0,0 +1,111 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "TargetIndexSubsystem.generated.h"
+
+class APawn;
+
+//Which kinds of pawns a query should return
+enum class ETargetKind : uint8
+{
+	None = 0,
+	Enemy = 1 << 0,
+	Player = 1 << 1,
+	Any = Enemy | Player,
+};
+ENUM_CLASS_FLAGS(ETargetKind);
+
+//Uniform grid of every enemy and player in the world, so combat lookups don't have to go through physics
+UCLASS(Config=Game)
+class Y25_API UTargetIndexSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Add or remove a pawn, enemies and players register themselves on spawn
+	void Register(APawn* Pawn);
+
+	void Unregister(APawn* Pawn);
+
+	//Living targets within Radius of Location
+	void QueryRadius(
+		const FVector& Location,
+		float Radius,
+		TArray<APawn*>& OutTargets,
+		ETargetKind Kinds = ETargetKind::Any) const;
+
+	//Up to MaxResults living targets within MaxDistance, closest first
+	void QueryNearest(
+		const FVector& Location,
+		float MaxDistance,
+		int32 MaxResults,
+		TArray<APawn*>& OutTargets,
+		ETargetKind Kinds = ETargetKind::Any,
+		const TSet<APawn*>* IgnoredTargets = nullptr) const;
+
+	//Living targets inside a cone, closest first
+	void QueryCone(
+		const FVector& Origin,
+		const FVector& Direction,
+		float HalfAngleRadians,
+		float MaxDistance,
+		TArray<APawn*>& OutTargets,
+		ETargetKind Kinds = ETargetKind::Any) const;
+
+	int32 GetNumTargets() const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	struct FTargetEntry
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		TObjectKey<APawn> Key;
+		FVector Location = FVector::ZeroVector;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		ETargetKind Kind = ETargetKind::None;
+	};
+
+	UFUNCTION()
+	void HandleActorDestroyed(AActor* DestroyedActor);
+
+	void HandleActorSpawned(AActor* SpawnedActor);
+
+	static ETargetKind GetTargetKind(const AActor* Actor);
+
+	static bool IsAlive(const FTargetEntry& Entry);
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void RemoveAt(int32 EntryIndex);
+
+	//Calls Visitor for every living entry whose cell overlaps the box around Location
+	template <typename FunctorType>
+	void ForEachInRange(const FVector& Location, float Range, ETargetKind Kinds, FunctorType&& Visitor) const;
+
+	//Width of a grid cell, enemies are indexed on the ground plane only
+	UPROPERTY(Config)
+	float CellSize = 1000.0f;
+
+	TSparseArray<FTargetEntry> Entries;
+
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	TMap<TObjectKey<APawn>, int32> EntryLookup;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -0,0 +1,207 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Y25/Combat/CombatMath.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	using namespace Y25::CombatMath;
+
+	constexpr float Tolerance = 1e-4f;
+
+	//Whole numbers keep squared distances exact in both paths, so radius and nearest checks can't differ by rounding
+	FPositionsSoA MakePositions(const int32 Num, FRandomStream& Stream)
+	{
+		FPositionsSoA Positions;
+		Positions.Reset(Num);
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			Positions.Add(FVector(
+				Stream.RandRange(-1000, 1000),
+				Stream.RandRange(-1000, 1000),
+				Stream.RandRange(-1000, 1000)));
+		}
+		return Positions;
+	}
+
+	bool TestPositionsEqual(
+		FAutomationTestBase& Test,
+		const TCHAR* What,
+		const FPositionsSoA& Actual,
+		const FPositionsSoA& Expected)
+	{
+		if (!Test.TestEqual(FString::Printf(TEXT("%s count"), What), Actual.Num(), Expected.Num()))
+		{
+			return false;
+		}
+		for (int32 Index = 0; Index < Expected.Num(); Index++)
+		{
+			if (!Actual.Get(Index).Equals(Expected.Get(Index), Tolerance))
+			{
+				Test.AddError(FString::Printf(
+					TEXT("%s differ at %d: %s vs %s"),
+					What,
+					Index,
+					*Actual.Get(Index).ToString(),
+					*Expected.Get(Index).ToString()));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Sizes around the register width, plus the benchmark sizes
+	constexpr int32 TestSizes[] = {0, 1, 3, 4, 5, 7, 64, 257, 1024};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FCombatMathSimdMatchesScalarTest,
+	"Y25.Combat.CombatMath.SimdMatchesScalar",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FCombatMathSimdMatchesScalarTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Stream(25);
+	const FVector Origin(12, -34, 56);
+
+	for (const int32 Num : TestSizes)
+	{
+		AddInfo(FString::Printf(TEXT("%d positions"), Num));
+		const FPositionsSoA Positions = MakePositions(Num, Stream);
+
+		TArray<float> DistSq;
+		TArray<float> ScalarDistSq;
+		DistSq.SetNumUninitialized(Num);
+		ScalarDistSq.SetNumUninitialized(Num);
+		DistanceSquared(Positions, Origin, DistSq);
+		Scalar::DistanceSquared(Positions, Origin, ScalarDistSq);
+		TestEqual(TEXT("DistanceSquared"), DistSq, ScalarDistSq);
+
+		TArray<int32> Indices;
+		TArray<int32> ScalarIndices;
+		FilterRadius(Positions, Origin, 900.5f, Indices);
+		Scalar::FilterRadius(Positions, Origin, 900.5f, ScalarIndices);
+		TestEqual(TEXT("FilterRadius"), Indices, ScalarIndices);
+
+		NearestK(Positions, Origin, 8, 1200.5f, Indices);
+		Scalar::NearestK(Positions, Origin, 8, 1200.5f, ScalarIndices);
+		TestEqual(TEXT("NearestK"), Indices, ScalarIndices);
+
+		TArray<float> Values;
+		TArray<float> ScalarValues;
+		Values.SetNumUninitialized(Num);
+		ScalarValues.SetNumUninitialized(Num);
+		Falloff(DistSq, 1500, 100, 0.25f, Values);
+		Scalar::Falloff(DistSq, 1500, 100, 0.25f, ScalarValues);
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			if (!FMath::IsNearlyEqual(Values[Index], ScalarValues[Index], Tolerance * 100))
+			{
+				AddError(FString::Printf(
+					TEXT("Falloff differs at %d: %f vs %f"),
+					Index,
+					Values[Index],
+					ScalarValues[Index]));
+				break;
+			}
+		}
+
+		FPositionsSoA Directions;
+		FPositionsSoA ScalarDirections;
+		LaunchDirections(Positions, Origin, Directions);
+		Scalar::LaunchDirections(Positions, Origin, ScalarDirections);
+		TestPositionsEqual(*this, TEXT("LaunchDirections"), Directions, ScalarDirections);
+
+		//Same seed so both paths draw the same samples
+		FRandomStream ConeStream(Num);
+		FRandomStream ScalarConeStream(Num);
+		ConeDirections(FVector(1, 2, 3), FMath::DegreesToRadians(10.0f), Num, ConeStream, Directions);
+		Scalar::ConeDirections(FVector(1, 2, 3), FMath::DegreesToRadians(10.0f), Num, ScalarConeStream, ScalarDirections);
+		TestPositionsEqual(*this, TEXT("ConeDirections"), Directions, ScalarDirections);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FCombatMathBenchmarkTest,
+	"Y25.Combat.CombatMath.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FCombatMathBenchmarkTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 Iterations = 2000;
+	const FVector Origin(12, -34, 56);
+
+	//Microseconds per call averaged over Iterations
+	auto Time = [](auto&& Kernel)
+	{
+		Kernel();
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			Kernel();
+		}
+		return (FPlatformTime::Seconds() - StartTime) / Iterations * 1000000;
+	};
+
+	auto Report = [this](const TCHAR* Kernel, const int32 Num, const double SimdTime, const double ScalarTime)
+	{
+		AddInfo(FString::Printf(
+			TEXT("%s x%d: %.2f us SIMD, %.2f us scalar, %.2fx"),
+			Kernel,
+			Num,
+			SimdTime,
+			ScalarTime,
+			SimdTime > 0 ? ScalarTime / SimdTime : 0));
+	};
+
+	for (const int32 Num : {64, 256, 1024})
+	{
+		FRandomStream Stream(Num);
+		const FPositionsSoA Positions = MakePositions(Num, Stream);
+		TArray<float> DistSq;
+		DistSq.SetNumUninitialized(Num);
+		TArray<float> Values;
+		Values.SetNumUninitialized(Num);
+		TArray<int32> Indices;
+		FPositionsSoA Directions;
+
+		Report(
+			TEXT("DistanceSquared"),
+			Num,
+			Time([&] { DistanceSquared(Positions, Origin, DistSq); }),
+			Time([&] { Scalar::DistanceSquared(Positions, Origin, DistSq); }));
+		Report(
+			TEXT("FilterRadius"),
+			Num,
+			Time([&] { FilterRadius(Positions, Origin, 900, Indices); }),
+			Time([&] { Scalar::FilterRadius(Positions, Origin, 900, Indices); }));
+		Report(
+			TEXT("NearestK"),
+			Num,
+			Time([&] { NearestK(Positions, Origin, 8, 1200, Indices); }),
+			Time([&] { Scalar::NearestK(Positions, Origin, 8, 1200, Indices); }));
+		Report(
+			TEXT("Falloff"),
+			Num,
+			Time([&] { Falloff(DistSq, 1500, 100, 0.25f, Values); }),
+			Time([&] { Scalar::Falloff(DistSq, 1500, 100, 0.25f, Values); }));
+		Report(
+			TEXT("LaunchDirections"),
+			Num,
+			Time([&] { LaunchDirections(Positions, Origin, Directions); }),
+			Time([&] { Scalar::LaunchDirections(Positions, Origin, Directions); }));
+		Report(
+			TEXT("ConeDirections"),
+			Num,
+			Time([&] { ConeDirections(FVector::ForwardVector, 0.2f, Num, Stream, Directions); }),
+			Time([&] { Scalar::ConeDirections(FVector::ForwardVector, 0.2f, Num, Stream, Directions); }));
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,46 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GameplayEffect.h"
+#include "Misc/AutomationTest.h"
+#include "Y25/Combat/EffectSpecCache.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	UGameplayEffect* MakeEffect(const EGameplayEffectAttributeCaptureSource Source, const bool bSnapshot)
+	{
+		FAttributeBasedFloat Magnitude;
+		Magnitude.BackingAttribute = FGameplayEffectAttributeCaptureDefinition(FGameplayAttribute(), Source, bSnapshot);
+
+		FGameplayModifierInfo Modifier;
+		Modifier.ModifierMagnitude = FGameplayEffectModifierMagnitude(Magnitude);
+
+		UGameplayEffect* Effect = NewObject<UGameplayEffect>();
+		Effect->Modifiers.Add(Modifier);
+		return Effect;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FEffectSpecCacheSnapshotTest,
+	"Y25.Combat.EffectSpecCache.Snapshots",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FEffectSpecCacheSnapshotTest::RunTest(const FString& Parameters)
+{
+	//Only a frozen source capture stops a spec being reused
+	TestFalse(TEXT("No captures"), FEffectSpecCache::HasSnapshottedSourceCaptures(*NewObject<UGameplayEffect>()));
+	TestFalse(
+		TEXT("Live source"),
+		FEffectSpecCache::HasSnapshottedSourceCaptures(*MakeEffect(EGameplayEffectAttributeCaptureSource::Source, false)));
+	TestFalse(
+		TEXT("Snapshotted target"),
+		FEffectSpecCache::HasSnapshottedSourceCaptures(*MakeEffect(EGameplayEffectAttributeCaptureSource::Target, true)));
+	TestTrue(
+		TEXT("Snapshotted source"),
+		FEffectSpecCache::HasSnapshottedSourceCaptures(*MakeEffect(EGameplayEffectAttributeCaptureSource::Source, true)));
+	return true;
+}
+
+#endif
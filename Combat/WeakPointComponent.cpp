@@ -0,0 +1,121 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "WeakPointComponent.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "GameFramework/Character.h"
+
+UWeakPointComponent::UWeakPointComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	//Matches the old single "Critical" socket check
+	WeakPoints.AddDefaulted();
+}
+
+void UWeakPointComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ResolveBones();
+}
+
+void UWeakPointComponent::ResolveBones()
+{
+	Resolved.Reset(WeakPoints.Num());
+
+	if (const ACharacter* Character = Cast<ACharacter>(GetOwner()))
+	{
+		Mesh = Character->GetMesh();
+	}
+
+	const USkeletalMesh* SkeletalMesh = Mesh ? Mesh->GetSkeletalMeshAsset() : nullptr;
+
+	for (const FWeakPoint& WeakPoint : WeakPoints)
+	{
+		FResolvedWeakPoint& Entry = Resolved.AddDefaulted_GetRef();
+		Entry.BoneName = WeakPoint.Bone;
+		Entry.BoneToShape = WeakPoint.Offset;
+
+		if (!SkeletalMesh)
+		{
+			continue;
+		}
+
+		//Sockets become their bone plus the socket's local offset
+		if (const USkeletalMeshSocket* Socket = SkeletalMesh->FindSocket(WeakPoint.Bone))
+		{
+			Entry.BoneName = Socket->BoneName;
+			Entry.BoneToShape = WeakPoint.Offset * Socket->GetSocketLocalTransform();
+		}
+
+		Entry.BoneIndex = Mesh->GetBoneIndex(Entry.BoneName);
+	}
+}
+
+bool UWeakPointComponent::Contains(const int32 WeakPointIndex, const FVector& Location) const
+{
+	const FResolvedWeakPoint& Entry = Resolved[WeakPointIndex];
+	if (Entry.BoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FWeakPoint& WeakPoint = WeakPoints[WeakPointIndex];
+	const FTransform ShapeTransform = Entry.BoneToShape * Mesh->GetBoneTransform(Entry.BoneIndex);
+
+	if (WeakPoint.Shape == EWeakPointShape::Capsule)
+	{
+		//Half height includes the end caps
+		const FVector Axis = ShapeTransform.GetUnitAxis(EAxis::Z) *
+			FMath::Max(WeakPoint.HalfHeight - WeakPoint.Radius, 0.0f);
+		const FVector Center = ShapeTransform.GetLocation();
+
+		return FMath::PointDistToSegmentSquared(Location, Center - Axis, Center + Axis) <=
+			FMath::Square(WeakPoint.Radius);
+	}
+
+	return FVector::DistSquared(Location, ShapeTransform.GetLocation()) <= FMath::Square(WeakPoint.Radius);
+}
+
+const FWeakPoint* UWeakPointComponent::FindWeakPoint(const FHitResult& HitResult) const
+{
+	if (!Mesh || Resolved.Num() != WeakPoints.Num())
+	{
+		return nullptr;
+	}
+
+	const FWeakPoint* Best = nullptr;
+
+	//Shapes on the bone the trace hit are the likely match, check them first
+	if (!HitResult.BoneName.IsNone())
+	{
+		for (int32 Index = 0; Index < Resolved.Num(); Index++)
+		{
+			if (Resolved[Index].BoneName == HitResult.BoneName && Contains(Index, HitResult.ImpactPoint) &&
+				(!Best || WeakPoints[Index].DamageMultiplier > Best->DamageMultiplier))
+			{
+				Best = &WeakPoints[Index];
+			}
+		}
+
+		if (Best)
+		{
+			return Best;
+		}
+	}
+
+	//Shapes can reach past their bone, so fall back to every other one
+	for (int32 Index = 0; Index < Resolved.Num(); Index++)
+	{
+		if (Resolved[Index].BoneName != HitResult.BoneName && Contains(Index, HitResult.ImpactPoint) &&
+			(!Best || WeakPoints[Index].DamageMultiplier > Best->DamageMultiplier))
+		{
+			Best = &WeakPoints[Index];
+		}
+	}
+
+	return Best;
+}
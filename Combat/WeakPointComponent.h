@@ -0,0 +1,79 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+
+#include "WeakPointComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+UENUM(BlueprintType)
+enum class EWeakPointShape : uint8
+{
+	Sphere,
+	Capsule,
+};
+
+USTRUCT(BlueprintType)
+struct FWeakPoint
+{
+	GENERATED_BODY()
+
+	//Bone or socket on the owner's mesh the shape follows
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point")
+	FName Bone = TEXT("Critical");
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point")
+	EWeakPointShape Shape = EWeakPointShape::Sphere;
+
+	//Relative to the bone or socket, capsules run along their local Z
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point")
+	FTransform Offset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point", meta = (ClampMin = 0))
+	float Radius = 20;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point",
+		meta = (ClampMin = 0, EditCondition = "Shape == EWeakPointShape::Capsule"))
+	float HalfHeight = 40;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Point")
+	float DamageMultiplier = 1.5;
+};
+
+//Critical hit shapes for an enemy, bones are resolved once instead of on every hit
+UCLASS(ClassGroup = (Y25), meta = (BlueprintSpawnableComponent))
+class Y25_API UWeakPointComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWeakPointComponent();
+
+	//Weak point under the hit, the strongest one if several overlap
+	const FWeakPoint* FindWeakPoint(const FHitResult& HitResult) const;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weak Points")
+	TArray<FWeakPoint> WeakPoints;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	struct FResolvedWeakPoint
+	{
+		FName BoneName;
+		int32 BoneIndex = INDEX_NONE;
+		FTransform BoneToShape;
+	};
+
+	void ResolveBones();
+
+	bool Contains(int32 WeakPointIndex, const FVector& Location) const;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> Mesh;
+
+	TArray<FResolvedWeakPoint> Resolved;
+};
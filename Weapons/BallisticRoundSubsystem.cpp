@@ -0,0 +1,229 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "BallisticRoundSubsystem.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "Y25/Values/Collision.h"
+#include "Y25/Weapons/Gun.h"
+
+bool UBallisticRoundSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallisticRoundSubsystem::Deinitialize()
+{
+	Positions.Empty();
+	Velocities.Empty();
+	RemainingDistances.Empty();
+	GravityScales.Empty();
+	Guns.Empty();
+	AmmoTypes.Empty();
+	Origins.Empty();
+	IgnoredActors.Empty();
+	States.Empty();
+	HitResults.Empty();
+	RoundHits.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UBallisticRoundSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBallisticRoundSubsystem, STATGROUP_Tickables);
+}
+
+int32 UBallisticRoundSubsystem::GetNumRounds() const
+{
+	return Positions.Num();
+}
+
+void UBallisticRoundSubsystem::Fire(
+	AGun* Gun,
+	const EAmmoType AmmoType,
+	const FVector& Start,
+	const FVector& Velocity,
+	const float MaxDistance,
+	const float GravityScale)
+{
+	Positions.Add(Start);
+	Velocities.Add(Velocity);
+	RemainingDistances.Add(MaxDistance);
+	GravityScales.Add(GravityScale);
+	Guns.Add(Gun);
+	AmmoTypes.Add(AmmoType);
+	Origins.Add(Start);
+}
+
+void UBallisticRoundSubsystem::CancelRounds(const AGun* Gun)
+{
+	//Rounds without a gun are spent on the next tick, impacts waiting to be handed back are skipped
+	for (TWeakObjectPtr<AGun>& RoundGun : Guns)
+	{
+		if (RoundGun == Gun)
+		{
+			RoundGun.Reset();
+		}
+	}
+	for (FRoundHit& RoundHit : RoundHits)
+	{
+		if (RoundHit.Gun == Gun)
+		{
+			RoundHit.Gun.Reset();
+		}
+	}
+}
+
+void UBallisticRoundSubsystem::Tick(const float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UBallisticRoundSubsystem::Tick);
+
+	Super::Tick(DeltaTime);
+
+	const int32 NumRounds = Positions.Num();
+	if (NumRounds == 0)
+	{
+		return;
+	}
+
+	const UWorld* World = GetWorld();
+	const float GravityZ = World->GetGravityZ();
+	const int32 NumSteps = FMath::Max(SubSteps, 1);
+	const float StepTime = DeltaTime / NumSteps;
+
+	//Rounds never hit the gun or player that fired them
+	IgnoredActors.SetNumUninitialized(NumRounds, EAllowShrinking::No);
+	States.SetNumUninitialized(NumRounds, EAllowShrinking::No);
+	HitResults.SetNum(NumRounds, EAllowShrinking::No);
+	for (int32 Index = 0; Index < NumRounds; Index++)
+	{
+		const AGun* Gun = Guns[Index].Get();
+		IgnoredActors[Index] = {Gun, Gun ? Gun->GetOwner() : nullptr};
+		States[Index] = Gun ? ERoundState::Flying : ERoundState::Spent;
+	}
+
+	//Same rules as a bullet trace, pawns block
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(Y25::Collision::Channels::Pawn, ECR_Block);
+
+	//Each round only touches its own entries, so rounds step independently
+	ParallelFor(NumRounds, [&](const int32 Index)
+	{
+		if (States[Index] != ERoundState::Flying)
+		{
+			return;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BallisticRound), false);
+		QueryParams.AddIgnoredActor(IgnoredActors[Index].Key);
+		QueryParams.AddIgnoredActor(IgnoredActors[Index].Value);
+
+		FVector Position = Positions[Index];
+		FVector Velocity = Velocities[Index];
+		float RemainingDistance = RemainingDistances[Index];
+
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			Velocity.Z += GravityZ * GravityScales[Index] * StepTime;
+			const FVector Next = Position + Velocity * StepTime;
+
+			if (World->LineTraceSingleByChannel(
+				HitResults[Index],
+				Position,
+				Next,
+				Y25::Collision::Channels::Weapon,
+				QueryParams,
+				ResponseParams))
+			{
+				States[Index] = ERoundState::Hit;
+				break;
+			}
+
+			RemainingDistance -= FVector::Dist(Position, Next);
+			Position = Next;
+
+			//Out of range
+			if (RemainingDistance <= 0)
+			{
+				States[Index] = ERoundState::Spent;
+				break;
+			}
+		}
+
+		Positions[Index] = Position;
+		Velocities[Index] = Velocity;
+		RemainingDistances[Index] = RemainingDistance;
+	}, NumRounds < ParallelThreshold ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	//Collect impacts in round order so results don't depend on thread timing
+	RoundHits.Reset();
+	for (int32 Index = 0; Index < NumRounds; Index++)
+	{
+		//Cancelled rounds have no gun and just vanish
+		if (States[Index] == ERoundState::Flying || !Guns[Index].IsValid())
+		{
+			continue;
+		}
+
+		FRoundHit& RoundHit = RoundHits.AddDefaulted_GetRef();
+		RoundHit.Gun = Guns[Index];
+		RoundHit.AmmoType = AmmoTypes[Index];
+		RoundHit.Origin = Origins[Index];
+		RoundHit.Direction = Velocities[Index].GetSafeNormal();
+
+		//Out of range still draws its tracer, to where the round gave out
+		if (States[Index] == ERoundState::Hit)
+		{
+			RoundHit.Hit = HitResults[Index];
+		}
+		else
+		{
+			RoundHit.Hit.TraceStart = Origins[Index];
+			RoundHit.Hit.TraceEnd = Positions[Index];
+		}
+	}
+
+	RemoveFinished();
+
+	for (FRoundHit& RoundHit : RoundHits)
+	{
+		if (AGun* Gun = RoundHit.Gun.Get())
+		{
+			Gun->OnBallisticRoundHit(RoundHit.AmmoType, RoundHit.Origin, RoundHit.Direction, RoundHit.Hit);
+		}
+	}
+}
+
+void UBallisticRoundSubsystem::RemoveFinished()
+{
+	//Keeps the remaining rounds in firing order
+	int32 Kept = 0;
+	for (int32 Index = 0; Index < States.Num(); Index++)
+	{
+		if (States[Index] != ERoundState::Flying)
+		{
+			continue;
+		}
+
+		if (Kept != Index)
+		{
+			Positions[Kept] = Positions[Index];
+			Velocities[Kept] = Velocities[Index];
+			RemainingDistances[Kept] = RemainingDistances[Index];
+			GravityScales[Kept] = GravityScales[Index];
+			Guns[Kept] = Guns[Index];
+			AmmoTypes[Kept] = AmmoTypes[Index];
+			Origins[Kept] = Origins[Index];
+		}
+		Kept++;
+	}
+
+	Positions.SetNum(Kept, EAllowShrinking::No);
+	Velocities.SetNum(Kept, EAllowShrinking::No);
+	RemainingDistances.SetNum(Kept, EAllowShrinking::No);
+	GravityScales.SetNum(Kept, EAllowShrinking::No);
+	Guns.SetNum(Kept, EAllowShrinking::No);
+	AmmoTypes.SetNum(Kept, EAllowShrinking::No);
+	Origins.SetNum(Kept, EAllowShrinking::No);
+}
@@ -0,0 +1,86 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "BallisticRoundSubsystem.generated.h"
+
+class AGun;
+enum class EAmmoType : uint8;
+
+//Bullets with travel time and drop. Each round in flight is an entry in a set of parallel arrays, stepped with a few
+//segment traces per tick across worker threads, and impacts go back to the gun that fired it in a fixed order.
+UCLASS(Config=Game)
+class Y25_API UBallisticRoundSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Start a round, gone once it hits something or has travelled MaxDistance. Lands as AmmoType no matter what the
+	//gun has loaded by then.
+	void Fire(
+		AGun* Gun,
+		EAmmoType AmmoType,
+		const FVector& Start,
+		const FVector& Velocity,
+		float MaxDistance,
+		float GravityScale);
+
+	//Drop every round Gun still has in flight, they land nowhere
+	void CancelRounds(const AGun* Gun);
+
+	int32 GetNumRounds() const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	enum class ERoundState : uint8
+	{
+		Flying,
+		Hit,
+		Spent,
+	};
+
+	//Segments traced per round per tick
+	UPROPERTY(Config)
+	int32 SubSteps = 2;
+
+	//Fewer rounds than this are stepped on the game thread
+	UPROPERTY(Config)
+	int32 ParallelThreshold = 64;
+
+	void RemoveFinished();
+
+	//Rounds in flight, one entry per array
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> RemainingDistances;
+	TArray<float> GravityScales;
+	TArray<TWeakObjectPtr<AGun>> Guns;
+	TArray<EAmmoType> AmmoTypes;
+	TArray<FVector> Origins;
+
+	//Per tick, filled before stepping so workers don't touch UObjects
+	TArray<TPair<const AActor*, const AActor*>> IgnoredActors;
+	TArray<ERoundState> States;
+	TArray<FHitResult> HitResults;
+
+	//Impacts and spent rounds handed to guns after the rounds are removed, spent rounds have no blocking hit
+	struct FRoundHit
+	{
+		TWeakObjectPtr<AGun> Gun;
+		EAmmoType AmmoType{};
+		FVector Origin;
+		FVector Direction;
+		FHitResult Hit;
+	};
+	TArray<FRoundHit> RoundHits;
+};
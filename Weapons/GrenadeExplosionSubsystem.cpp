@@ -0,0 +1,470 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GrenadeExplosionSubsystem.h"
+
+#include "AbilitySystemGlobals.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/DamageType.h"
+#include "GameplayCueManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Y25/Combat/DamageOverTimeSubsystem.h"
+#include "Y25/Combat/TargetIndexSubsystem.h"
+#include "Y25/Enemies/BaseEnemy.h"
+#include "Y25/Gameplay/Cues.h"
+#include "Y25/Gameplay/Tags.h"
+#include "Y25/Player/MainCharacter.h"
+#include "Y25/Values/Collision.h"
+#include "Y25/Weapons/GrenadeProjectile.h"
+
+//Distance from Location to the surface of Target's capsule, what the sphere overlap measures
+static double DistanceToCapsule(const APawn* Target, const FVector& Location)
+{
+	const ACharacter* Character = Cast<ACharacter>(Target);
+	const UCapsuleComponent* Capsule = Character ? Character->GetCapsuleComponent() : nullptr;
+	if (!Capsule)
+	{
+		return FVector::Dist(Location, Target->GetActorLocation());
+	}
+
+	const FVector Center = Capsule->GetComponentLocation();
+	const FVector Axis = Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+	const FVector Closest = FMath::ClosestPointOnSegment(Location, Center - Axis, Center + Axis);
+	return FMath::Max(FVector::Dist(Location, Closest) - Capsule->GetScaledCapsuleRadius(), 0.0);
+}
+
+bool UGrenadeExplosionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGrenadeExplosionSubsystem::Deinitialize()
+{
+	Queued.Empty();
+	Current = FBlastBatch();
+	InFlight.Empty();
+	OcclusionCache.Empty();
+	BatchTraces.Empty();
+	PendingHits.Empty();
+	PendingHitIndices.Empty();
+	IndexedTargets.Empty();
+	Overlaps.Empty();
+	SeenTargets.Empty();
+	DamagedActors.Empty();
+	AllyDamageSpecs.Reset();
+
+	Super::Deinitialize();
+}
+
+TStatId UGrenadeExplosionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGrenadeExplosionSubsystem, STATGROUP_Tickables);
+}
+
+void UGrenadeExplosionSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	//Last frame's cover traces
+	for (int32 Index = 0; Index < InFlight.Num(); Index++)
+	{
+		if (ReadOcclusion(InFlight[Index]))
+		{
+			ApplyBatch(InFlight[Index]);
+			InFlight.RemoveAt(Index--);
+		}
+	}
+
+	Flush();
+}
+
+void UGrenadeExplosionSubsystem::Queue(const FGrenadeExplosion& Explosion)
+{
+	Queued.Add(Explosion);
+}
+
+void UGrenadeExplosionSubsystem::GatherTargets(
+	const FVector& Location,
+	const float Radius,
+	const AActor* IgnoredActor,
+	TArray<AActor*>& OutTargets)
+{
+	OutTargets.Reset();
+
+	//Every player and enemy is already in the index, no physics needed
+	if (const UTargetIndexSubsystem* TargetIndex = GetWorld()->GetSubsystem<UTargetIndexSubsystem>();
+		TargetIndex && TargetIndex->GetNumTargets() > 0)
+	{
+		//Index holds origins, pad the query so capsules whose edge is in the blast are still found
+		TargetIndex->QueryRadius(Location, Radius + MaxTargetExtent, IndexedTargets);
+		for (APawn* Target : IndexedTargets)
+		{
+			if (Target != IgnoredActor && DistanceToCapsule(Target, Location) <= Radius)
+			{
+				OutTargets.Add(Target);
+			}
+		}
+		return;
+	}
+
+	//Pawn objects only, so level geometry never reaches the filter
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	ObjectParams.AddObjectTypesToQuery(Y25::Collision::Channels::Pawn);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GrenadeExplosion), false, IgnoredActor);
+
+	Overlaps.Reset();
+	GetWorld()->OverlapMultiByObjectType(
+		Overlaps,
+		Location,
+		FQuat::Identity,
+		ObjectParams,
+		FCollisionShape::MakeSphere(Radius),
+		QueryParams);
+
+	//An actor with several overlapping components still only takes one hit
+	SeenTargets.Reset();
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Target = Overlap.GetActor();
+		if (!Target || !(Target->IsA(ABaseEnemy::StaticClass()) || Target->IsA(AMainCharacter::StaticClass())))
+		{
+			continue;
+		}
+
+		bool bAlreadySeen = false;
+		SeenTargets.Add(Target, &bAlreadySeen);
+		if (!bAlreadySeen)
+		{
+			OutTargets.Add(Target);
+		}
+	}
+}
+
+void UGrenadeExplosionSubsystem::Flush()
+{
+	if (Queued.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UGrenadeExplosionSubsystem::Flush);
+
+	PlayCues();
+
+	Current.Explosions = Queued;
+	Queued.Reset();
+	GatherHits(Current);
+
+	//Wait for cover traces unless every answer was cached
+	if (bCheckOcclusion && !RequestOcclusion(Current))
+	{
+		InFlight.Add(MoveTemp(Current));
+		Current = FBlastBatch();
+		return;
+	}
+
+	ApplyBatch(Current);
+}
+
+FIntVector UGrenadeExplosionSubsystem::GetOcclusionCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt32(Location.X / OcclusionCellSize),
+		FMath::FloorToInt32(Location.Y / OcclusionCellSize),
+		FMath::FloorToInt32(Location.Z / OcclusionCellSize));
+}
+
+void UGrenadeExplosionSubsystem::PlayCues()
+{
+	//Group blasts around the first one in each group, one cue at the middle of each
+	TArray<int32, TInlineAllocator<16>> Clusters;
+	TArray<FVector, TInlineAllocator<16>> ClusterSums;
+	TArray<int32, TInlineAllocator<16>> ClusterCounts;
+
+	const double ClusterRadiusSq = FMath::Square(CueClusterRadius);
+	for (int32 Index = 0; Index < Queued.Num(); Index++)
+	{
+		const FVector& Location = Queued[Index].Location;
+
+		int32 Cluster = Clusters.IndexOfByPredicate([&](const int32 First)
+		{
+			return FVector::DistSquared(Queued[First].Location, Location) <= ClusterRadiusSq;
+		});
+
+		if (Cluster == INDEX_NONE)
+		{
+			Cluster = Clusters.Add(Index);
+			ClusterSums.Add(FVector::ZeroVector);
+			ClusterCounts.Add(0);
+		}
+
+		ClusterSums[Cluster] += Location;
+		ClusterCounts[Cluster]++;
+	}
+
+	for (int32 Cluster = 0; Cluster < Clusters.Num(); Cluster++)
+	{
+		const FGrenadeExplosion& First = Queued[Clusters[Cluster]];
+		AMainPlayerController* InstigatingPlayer = First.Instigator.Get();
+
+		//Explosion effect, magnitude is how many blasts it stands for
+		FGameplayCueParameters CueParam;
+
+		CueParam.Instigator = InstigatingPlayer;
+		CueParam.SourceObject = First.DamageCauser.Get(true);
+		CueParam.Location = ClusterSums[Cluster] / ClusterCounts[Cluster];
+		CueParam.RawMagnitude = ClusterCounts[Cluster];
+
+		UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
+			InstigatingPlayer,
+			Y25::Cues::Gun_AmmoHit_Grenade,
+			CueParam);
+	}
+}
+
+void UGrenadeExplosionSubsystem::GatherHits(FBlastBatch& Batch)
+{
+	Batch.Hits.Reset();
+
+	for (int32 ExplosionIndex = 0; ExplosionIndex < Batch.Explosions.Num(); ExplosionIndex++)
+	{
+		const FGrenadeExplosion& Explosion = Batch.Explosions[ExplosionIndex];
+
+		//Deal damage to all in radius
+		GatherTargets(Explosion.Location, Explosion.Radius, Explosion.IgnoredActor.Get(true), DamagedActors);
+
+		//Knockback direction and damage for every target in one batch
+		TargetLocations.Reset(DamagedActors.Num());
+		for (const AActor* DamagedActor : DamagedActors)
+		{
+			TargetLocations.Add(DamagedActor->GetActorLocation());
+		}
+
+		TargetDistSq.SetNumUninitialized(DamagedActors.Num(), EAllowShrinking::No);
+		TargetDamages.SetNumUninitialized(DamagedActors.Num(), EAllowShrinking::No);
+
+		Y25::CombatMath::LaunchDirections(TargetLocations, Explosion.Location, LaunchDirections);
+		Y25::CombatMath::DistanceSquared(TargetLocations, Explosion.Location, TargetDistSq);
+		Y25::CombatMath::Falloff(
+			TargetDistSq,
+			Explosion.Radius,
+			Explosion.Damage,
+			Explosion.FalloffMinScale,
+			TargetDamages);
+
+		const FIntVector ExplosionCell = GetOcclusionCell(Explosion.Location);
+		for (int32 Index = 0; Index < DamagedActors.Num(); Index++)
+		{
+			AActor* DamagedActor = DamagedActors[Index];
+
+			//Knockback, less to anything airborne
+			float LaunchForce = Explosion.Knockback;
+			if (const ACharacter* DamagedCharacter = Cast<ACharacter>(DamagedActor);
+				DamagedCharacter && !DamagedCharacter->GetMovementComponent()->IsMovingOnGround())
+			{
+				LaunchForce = LaunchForce / 1000;
+			}
+
+			FBlastHit& Hit = Batch.Hits.AddDefaulted_GetRef();
+			Hit.Target = DamagedActor;
+			Hit.Explosion = ExplosionIndex;
+			Hit.Damage = TargetDamages[Index];
+			Hit.Launch = LaunchDirections.Get(Index) * LaunchForce;
+			Hit.OcclusionKey = FOcclusionKey(ExplosionCell, GetOcclusionCell(TargetLocations.Get(Index)));
+		}
+	}
+}
+
+bool UGrenadeExplosionSubsystem::RequestOcclusion(FBlastBatch& Batch)
+{
+	UWorld* World = GetWorld();
+	const double Now = World->GetTimeSeconds();
+
+	//Only level geometry counts as cover, which is what makes the results safe to cache
+	const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GrenadeOcclusion), false);
+
+	bool bAllCached = true;
+	BatchTraces.Reset();
+	for (FBlastHit& Hit : Batch.Hits)
+	{
+		if (const FOcclusionResult* Cached = OcclusionCache.Find(Hit.OcclusionKey);
+			Cached && Now - Cached->Time <= OcclusionCacheLifetime)
+		{
+			Hit.bOccluded = Cached->bOccluded;
+			continue;
+		}
+
+		bAllCached = false;
+
+		//One trace per pair of cells, shared by every hit in them
+		if (const FTraceHandle* Existing = BatchTraces.Find(Hit.OcclusionKey))
+		{
+			Hit.Trace = *Existing;
+			continue;
+		}
+
+		const AActor* Target = Hit.Target.Get();
+		if (!Target)
+		{
+			continue;
+		}
+
+		Hit.Trace = World->AsyncLineTraceByObjectType(
+			EAsyncTraceType::Test,
+			Batch.Explosions[Hit.Explosion].Location,
+			Target->GetActorLocation(),
+			ObjectParams,
+			QueryParams);
+		BatchTraces.Add(Hit.OcclusionKey, Hit.Trace);
+	}
+
+	return bAllCached;
+}
+
+bool UGrenadeExplosionSubsystem::ReadOcclusion(FBlastBatch& Batch)
+{
+	UWorld* World = GetWorld();
+	const double Now = World->GetTimeSeconds();
+
+	for (FBlastHit& Hit : Batch.Hits)
+	{
+		if (!Hit.Trace.IsValid())
+		{
+			continue;
+		}
+
+		FTraceDatum Datum;
+		if (World->QueryTraceData(Hit.Trace, Datum))
+		{
+			Hit.bOccluded = Datum.OutHits.ContainsByPredicate([](const FHitResult& TraceHit)
+			{
+				return TraceHit.bBlockingHit;
+			});
+			OcclusionCache.Add(Hit.OcclusionKey, {Hit.bOccluded, Now});
+		}
+		//Still running
+		else if (World->IsTraceHandleValid(Hit.Trace, false))
+		{
+			return false;
+		}
+
+		Hit.Trace = FTraceHandle();
+	}
+
+	//Drop stale cover results once the cache gets big
+	if (OcclusionCache.Num() > 4096)
+	{
+		for (auto It = OcclusionCache.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value().Time > OcclusionCacheLifetime)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	return true;
+}
+
+void UGrenadeExplosionSubsystem::ApplyBatch(const FBlastBatch& Batch)
+{
+	//Merge every blast's share of damage and knockback per target
+	PendingHits.Reset();
+	PendingHitIndices.Reset();
+	for (const FBlastHit& BlastHit : Batch.Hits)
+	{
+		const AActor* DamagedActor = BlastHit.Target.Get();
+		if (!DamagedActor || BlastHit.bOccluded)
+		{
+			continue;
+		}
+
+		const int32* Existing = PendingHitIndices.Find(DamagedActor);
+		FPendingHit& Hit = Existing ? PendingHits[*Existing] : PendingHits.AddDefaulted_GetRef();
+		if (!Existing)
+		{
+			Hit.Target = BlastHit.Target;
+			PendingHitIndices.Add(DamagedActor, PendingHits.Num() - 1);
+		}
+
+		Hit.Damage += BlastHit.Damage;
+		Hit.Launch += BlastHit.Launch;
+		if (BlastHit.Damage > Hit.TopDamage || Hit.Explosion == INDEX_NONE)
+		{
+			Hit.TopDamage = BlastHit.Damage;
+			Hit.Explosion = BlastHit.Explosion;
+		}
+	}
+
+	for (const FPendingHit& Hit : PendingHits)
+	{
+		AActor* DamagedActor = Hit.Target.Get();
+		if (!DamagedActor)
+		{
+			continue;
+		}
+
+		const FGrenadeExplosion& Explosion = Batch.Explosions[Hit.Explosion];
+		AMainPlayerController* InstigatingPlayer = Explosion.Instigator.Get();
+		AActor* DamageCauser = Explosion.DamageCauser.Get(true);
+
+		//deal damage to enemy
+		if (ABaseEnemy* DamagedEnemy = Cast<ABaseEnemy>(DamagedActor))
+		{
+			if (!DamagedEnemy->IsDead())
+			{
+				UGameplayStatics::ApplyDamage(
+				DamagedEnemy,
+				Hit.Damage,
+				InstigatingPlayer,
+				DamageCauser,
+				UDamageType::StaticClass());
+
+				// add to bots killed
+				if (AControlPlayerState* ControlPlayerState =
+						InstigatingPlayer ? InstigatingPlayer->GetPlayerState<AControlPlayerState>() : nullptr;
+					DamagedEnemy->Health->GetHealth() <= 0 && ControlPlayerState)
+				{
+					ControlPlayerState->PlayerEndStats.FindOrAdd(TEXT("Bot Kills"))++;
+					ControlPlayerState->PlayerTrueStats.FindOrAdd(TEXT("Bot Kills"))++;
+					ControlPlayerState->UpdateScore();
+				}
+
+				DamagedEnemy->LaunchCharacter(Hit.Launch, true, false);
+
+				//Burning grenades keep hurting after the blast
+				if (Explosion.BurnDuration > 0 && !DamagedEnemy->IsDead())
+				{
+					if (UDamageOverTimeSubsystem* DamageOverTime = GetWorld()->GetSubsystem<UDamageOverTimeSubsystem>())
+					{
+						DamageOverTime->Apply(
+							DamagedEnemy,
+							Explosion.BurnDamagePerSecond,
+							Explosion.BurnDuration,
+							InstigatingPlayer,
+							DamageCauser);
+					}
+				}
+			}
+		}
+
+		//deal damage to ally
+		else if (AMainCharacter* DamagedChar = Cast<AMainCharacter>(DamagedActor))
+		{
+			// Damage effect
+			UY25_AbilitySystemComponent* AbilitySystemComponent = DamagedChar->GetAbilitySystemComponent();
+
+			//Credited to the grenade, pooled grenades keep reusing their spec on each ally
+			if (!DamagedChar->GetIsDead())
+			{
+				AllyDamageSpecs.Apply(Explosion.DamageEffect, AbilitySystemComponent, DamageCauser, Hit.Damage);
+			}
+
+			DamagedChar->LaunchCharacter(Hit.Launch, true, false);
+		}
+	}
+}
@@ -0,0 +1,136 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Engine/OverlapResult.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Y25/Combat/CombatMath.h"
+#include "Y25/Combat/EffectSpecCache.h"
+#include "Y25/Weapons/GrenadeProjectile.h"
+
+#include "GrenadeExplosionSubsystem.generated.h"
+
+//Resolves grenade blasts against players and enemies only. Blasts queued during a frame are resolved together,
+//so each target takes one combined hit and one knockback and nearby blasts share a cue. With occlusion on, the
+//frame's cover checks go out as one batch of async traces and damage lands when they come back.
+UCLASS(Config=Game)
+class Y25_API UGrenadeExplosionSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Resolved with every other blast this frame
+	void Queue(const FGrenadeExplosion& Explosion);
+
+	//Resolve everything queued so far, blasts waiting on cover traces resolve on a later tick
+	void Flush();
+
+	//Each player and enemy within Radius of Location once, read from the target index when there is one
+	void GatherTargets(const FVector& Location, float Radius, const AActor* IgnoredActor, TArray<AActor*>& OutTargets);
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	using FOcclusionKey = TPair<FIntVector, FIntVector>;
+
+	//Damage and knockback one blast gives one target
+	struct FBlastHit
+	{
+		TWeakObjectPtr<AActor> Target;
+		int32 Explosion = INDEX_NONE;
+		float Damage = 0;
+		FVector Launch = FVector::ZeroVector;
+		FOcclusionKey OcclusionKey;
+		FTraceHandle Trace;
+		bool bOccluded = false;
+	};
+
+	//Blasts from one frame, held until their cover traces land
+	struct FBlastBatch
+	{
+		TArray<FGrenadeExplosion> Explosions;
+		TArray<FBlastHit> Hits;
+	};
+
+	//Everything one target takes this frame
+	struct FPendingHit
+	{
+		TWeakObjectPtr<AActor> Target;
+		float Damage = 0;
+		FVector Launch = FVector::ZeroVector;
+		//Blast that did the most damage, credited with the hit
+		int32 Explosion = INDEX_NONE;
+		float TopDamage = 0;
+	};
+
+	struct FOcclusionResult
+	{
+		bool bOccluded = false;
+		double Time = 0;
+	};
+
+	//Blasts closer than this share one cue
+	UPROPERTY(Config)
+	float CueClusterRadius = 300;
+
+	//Farthest any target's capsule reaches from its origin, index queries are padded by this
+	UPROPERTY(Config)
+	float MaxTargetExtent = 100;
+
+	//Level geometry between a blast and a target blocks the damage
+	UPROPERTY(Config)
+	bool bCheckOcclusion = false;
+
+	//Blasts and targets in the same cells reuse a cover result for OcclusionCacheLifetime seconds
+	UPROPERTY(Config)
+	float OcclusionCellSize = 100;
+
+	UPROPERTY(Config)
+	float OcclusionCacheLifetime = 1;
+
+	void PlayCues();
+
+	void GatherHits(FBlastBatch& Batch);
+
+	//Start cover traces for hits not in the cache, false if any are still in flight
+	bool RequestOcclusion(FBlastBatch& Batch);
+
+	//Read landed cover traces, false if any are still in flight
+	bool ReadOcclusion(FBlastBatch& Batch);
+
+	void ApplyBatch(const FBlastBatch& Batch);
+
+	FIntVector GetOcclusionCell(const FVector& Location) const;
+
+	TArray<FGrenadeExplosion> Queued;
+
+	//Reused whenever a frame's blasts don't have to wait on traces
+	FBlastBatch Current;
+
+	TArray<FBlastBatch> InFlight;
+
+	TMap<FOcclusionKey, FOcclusionResult> OcclusionCache;
+	TMap<FOcclusionKey, FTraceHandle> BatchTraces;
+
+	//Damage specs per ally, DamageEffect and grenade
+	FEffectSpecCache AllyDamageSpecs;
+
+	//Scratch space kept between frames
+	TArray<FPendingHit> PendingHits;
+	TMap<const AActor*, int32> PendingHitIndices;
+	TArray<APawn*> IndexedTargets;
+	TArray<FOverlapResult> Overlaps;
+	TSet<const AActor*> SeenTargets;
+	TArray<AActor*> DamagedActors;
+	Y25::CombatMath::FPositionsSoA TargetLocations;
+	Y25::CombatMath::FPositionsSoA LaunchDirections;
+	TArray<float> TargetDistSq;
+	TArray<float> TargetDamages;
+};
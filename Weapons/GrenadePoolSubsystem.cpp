@@ -0,0 +1,127 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GrenadePoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "Y25/Weapons/GrenadeProjectile.h"
+
+bool UGrenadePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGrenadePoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGrenadePoolSubsystem::Prewarm(
+	const TSubclassOf<AGrenadeProjectile> GrenadeClass,
+	AController* Player,
+	AActor* Owner,
+	const int32 Count)
+{
+	if (!GrenadeClass || !Player)
+	{
+		return;
+	}
+
+	FGrenadePool& Pool = Pools.FindOrAdd(Player);
+	while (Pool.Free.Num() < Count)
+	{
+		AGrenadeProjectile* Grenade = SpawnPooled(GrenadeClass, Player, Owner);
+		if (!Grenade)
+		{
+			return;
+		}
+		Pool.Free.Add(Grenade);
+	}
+}
+
+AGrenadeProjectile* UGrenadePoolSubsystem::Acquire(
+	const TSubclassOf<AGrenadeProjectile> GrenadeClass,
+	AController* Player,
+	AActor* Owner,
+	const FTransform& Transform)
+{
+	if (!GrenadeClass || !Player)
+	{
+		return nullptr;
+	}
+
+	AGrenadeProjectile* Grenade = nullptr;
+
+	//Newest first, skipping anything destroyed with the level or of another class
+	FGrenadePool& Pool = Pools.FindOrAdd(Player);
+	for (int32 Index = Pool.Free.Num() - 1; Index >= 0; Index--)
+	{
+		AGrenadeProjectile* Candidate = Pool.Free[Index];
+		if (!IsValid(Candidate))
+		{
+			Pool.Free.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+		if (Candidate->GetClass() == GrenadeClass)
+		{
+			Pool.Free.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			Grenade = Candidate;
+			break;
+		}
+	}
+
+	if (!Grenade)
+	{
+		Grenade = SpawnPooled(GrenadeClass, Player, Owner);
+		if (!Grenade)
+		{
+			return nullptr;
+		}
+	}
+
+	Grenade->SetOwner(Owner);
+	Grenade->SetInstigator(Cast<APawn>(Owner));
+	Grenade->ActivateFromPool(Transform);
+
+	return Grenade;
+}
+
+bool UGrenadePoolSubsystem::Release(AGrenadeProjectile* Grenade)
+{
+	AController* Player = Grenade ? Grenade->PoolPlayer.Get() : nullptr;
+	if (!Player)
+	{
+		return false;
+	}
+
+	Grenade->DeactivateToPool();
+	Pools.FindOrAdd(Player).Free.Add(Grenade);
+
+	return true;
+}
+
+AGrenadeProjectile* UGrenadePoolSubsystem::SpawnPooled(
+	const TSubclassOf<AGrenadeProjectile> GrenadeClass,
+	AController* Player,
+	AActor* Owner)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = Owner;
+	SpawnParameters.Instigator = Cast<APawn>(Owner);
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AGrenadeProjectile* Grenade = GetWorld()->SpawnActor<AGrenadeProjectile>(
+		GrenadeClass,
+		FTransform::Identity,
+		SpawnParameters);
+
+	if (Grenade)
+	{
+		Grenade->PoolPlayer = Player;
+		Grenade->DeactivateToPool();
+	}
+
+	return Grenade;
+}
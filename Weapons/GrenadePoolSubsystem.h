@@ -0,0 +1,51 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GrenadePoolSubsystem.generated.h"
+
+class AController;
+class AGrenadeProjectile;
+
+USTRUCT()
+struct FGrenadePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AGrenadeProjectile>> Free;
+};
+
+//Keeps inactive grenades around per player so firing doesn't spawn and destroy actors
+UCLASS()
+class Y25_API UGrenadePoolSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//Spawn grenades ahead of time until the player has Count free
+	void Prewarm(TSubclassOf<AGrenadeProjectile> GrenadeClass, AController* Player, AActor* Owner, int32 Count);
+
+	//Free grenade moved to Transform and made visible, grows the pool if none are free
+	AGrenadeProjectile* Acquire(
+		TSubclassOf<AGrenadeProjectile> GrenadeClass,
+		AController* Player,
+		AActor* Owner,
+		const FTransform& Transform);
+
+	//Returns false if the grenade didn't come from a pool
+	bool Release(AGrenadeProjectile* Grenade);
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	AGrenadeProjectile* SpawnPooled(TSubclassOf<AGrenadeProjectile> GrenadeClass, AController* Player, AActor* Owner);
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<AController>, FGrenadePool> Pools;
+};
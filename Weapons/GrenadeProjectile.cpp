@@ -3,15 +3,14 @@
 #include "GrenadeProjectile.h"
 
 #include "AbilitySystemGlobals.h"
-#include "GameFramework/DamageType.h"
 #include "Math/Vector.h"
 #include "GameFramework/ProjectileMovementComponent.h"
-#include "Kismet/GameplayStatics.h"
 #include "GameplayCueManager.h"
 #include "Y25/Enemies/BaseEnemy.h"
 #include "Y25/Gameplay/Cues.h"
-#include "Y25/Gameplay/Tags.h"
 #include "Y25/Player/MainCharacter.h"
+#include "Y25/Weapons/GrenadeExplosionSubsystem.h"
+#include "Y25/Weapons/GrenadePoolSubsystem.h"
 
 AGrenadeProjectile::AGrenadeProjectile()
 {
@@ -27,33 +26,62 @@ void AGrenadeProjectile::BeginPlay()
 {
 	Super::BeginPlay();
 
-	//Grenade should only last 5 seconds max
-	AGrenadeProjectile::SetLifeSpan(5.0f);
-
 	//On hit event
 	if (HitboxCollision)
 	{
 		HitboxCollision->OnComponentHit.AddDynamic(this, &AGrenadeProjectile::OnHit);
 	}
+}
 
-	// hit tracking
-	EnemyHits = InstigatorVar->GetPlayerState<AControlPlayerState>()->PlayerEndStats.Find(TEXT("Bot Hits"));
-	FriendHits = InstigatorVar->GetPlayerState<AControlPlayerState>()->PlayerEndStats.Find(TEXT("Friend Hits"));
-	BotKills = InstigatorVar->GetPlayerState<AControlPlayerState>()->PlayerEndStats.Find(TEXT("Bot Kills"));
+void AGrenadeProjectile::ActivateFromPool(const FTransform& Transform)
+{
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
 
-	FriendTrueHits = InstigatorVar->GetPlayerState<AControlPlayerState>()->PlayerTrueStats.Find(TEXT("Friend Hits"));
-	BotTrueKills = InstigatorVar->GetPlayerState<AControlPlayerState>()->PlayerTrueStats.Find(TEXT("Bot Kills"));
+	ProjectileMovementComponent->SetUpdatedComponent(GetRootComponent());
 }
 
-void AGrenadeProjectile::UpdateAccuracy()
+void AGrenadeProjectile::DeactivateToPool()
 {
-	if (AControlPlayerState* PlayerState = InstigatorVar->GetPlayerState<AControlPlayerState>())
+	//Stop the timer and movement so nothing fires while parked
+	SetLifeSpan(0);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	ProjectileMovementComponent->StopMovementImmediately();
+	ProjectileMovementComponent->Deactivate();
+
+	//End the ammo trail, normally done when the grenade is destroyed
+	UAbilitySystemGlobals::Get().GetGameplayCueManager()->EndGameplayCuesFor(this);
+}
+
+void AGrenadeProjectile::RecordImpact(const AMainPlayerController* InstigatingPlayer, const AActor* OtherActor)
+{
+	AControlPlayerState* PlayerState = InstigatingPlayer ? InstigatingPlayer->GetPlayerState<AControlPlayerState>() : nullptr;
+	if (!PlayerState)
 	{
+		return;
+	}
+
+	//If enemy
+	if (OtherActor->IsA(ABaseEnemy::StaticClass()))
+	{
+		PlayerState->PlayerEndStats.FindOrAdd(TEXT("Bot Hits"))++;
+
 		const float BotHits = PlayerState->PlayerEndStats.FindRef("Bot Hits");
 		const float ShotsFired = PlayerState->PlayerEndStats.FindRef("Shots Fired");
 
 		PlayerState->PlayerTrueStats.FindOrAdd("Accuracy") = BotHits / ShotsFired;
 	}
+	//If player
+	else if (OtherActor->IsA(AMainCharacter::StaticClass()))
+	{
+		PlayerState->PlayerEndStats.FindOrAdd(TEXT("Friend Hits"))++;
+		PlayerState->PlayerTrueStats.FindOrAdd(TEXT("Friend Hits"))++;
+	}
 }
 
 void AGrenadeProjectile::NewInitialize(
@@ -65,6 +93,9 @@ void AGrenadeProjectile::NewInitialize(
 {
 	Super::Initialize(Damage, MaxSpeed, StartSpeed);
 
+	//Grenade should only last 5 seconds max
+	SetLifeSpan(5.0f);
+
 	//Set up base values
 	DamageAmount = Damage;
 
@@ -104,139 +135,56 @@ void AGrenadeProjectile::OnHit(
 		{
 			return;
 		}
-		//If enemy
-		if (OtherActor->IsA(ABaseEnemy::StaticClass()))
-		{
-			(*EnemyHits)++;
-			UpdateAccuracy();
-		}
-		//If player
-		else if (OtherActor->IsA(AMainCharacter::StaticClass()))
-		{
-			(*FriendHits)++;
-			(*FriendTrueHits)++;
-		}
+		RecordImpact(InstigatorVar, OtherActor);
 		Explode();
 	}
 }
 
 void AGrenadeProjectile::Explode()
 {
-	//Explosion effect
-	FGameplayCueParameters CueParam;
-
-	CueParam.Instigator = InstigatorVar;
-	CueParam.SourceObject = this;
-	CueParam.Location = GetActorLocation();
-
-	UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
-		InstigatorVar,
-		Y25::Cues::Gun_AmmoHit_Grenade,
-		CueParam);
-
-	//Deal damage to all in radius
-	TArray<AActor*> DamagedActors;
+	ResolveExplosion(GetWorld(), MakeExplosion(GetActorLocation()));
 
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this);
-
-	TArray<AActor*> ActorsToIgnore;
-	ActorsToIgnore.Add(this);
+	//Pooled grenades go back to their player's pool
+	if (UGrenadePoolSubsystem* GrenadePool = GetWorld()->GetSubsystem<UGrenadePoolSubsystem>();
+		!GrenadePool || !GrenadePool->Release(this))
+	{
+		Destroy();
+	}
+}
 
-	UKismetSystemLibrary::SphereOverlapActors(
-		this,
-		GetActorLocation(),
-		DamageRadius,
-		TArray<TEnumAsByte<EObjectTypeQuery>>(),
-		nullptr,
-		ActorsToIgnore,
-		DamagedActors);
+FGrenadeExplosion AGrenadeProjectile::MakeExplosion(const FVector& Location)
+{
+	FGrenadeExplosion Explosion;
+	Explosion.Location = Location;
+	Explosion.Damage = DamageAmount;
+	Explosion.Radius = DamageRadius;
+	Explosion.FalloffMinScale = DamageFalloffMinScale;
+	Explosion.BurnDamagePerSecond = BurnDamagePerSecond;
+	Explosion.BurnDuration = BurnDuration;
+	Explosion.Knockback = GrenadeKnockback;
+	Explosion.DamageEffect = DamageEffect;
+	Explosion.Instigator = InstigatorVar;
+	Explosion.DamageCauser = this;
+	Explosion.IgnoredActor = this;
+	return Explosion;
+}
 
-	for (AActor* DamagedActor : DamagedActors)
+void AGrenadeProjectile::ResolveExplosion(UWorld* World, const FGrenadeExplosion& Explosion)
+{
+	if (UGrenadeExplosionSubsystem* Explosions = World ? World->GetSubsystem<UGrenadeExplosionSubsystem>() : nullptr)
 	{
-		//If player or enemy
-		if (DamagedActor && (DamagedActor->IsA(ABaseEnemy::StaticClass()) ||
-			DamagedActor->IsA(AMainCharacter::StaticClass())))
-		{
-			//Get direction to launch
-			FVector EnemyLaunch = DamagedActor->GetActorLocation() - GetActorLocation();
-			if (EnemyLaunch.Z > 0)
-			{
-				EnemyLaunch.Z = 0;
-			}
-			EnemyLaunch.Normalize();
-
-			//deal damage to enemy
-			if (DamagedActor->IsA(ABaseEnemy::StaticClass()))
-			{
-				ABaseEnemy* DamagedEnemy = Cast<ABaseEnemy>(DamagedActor);
-
-				if (!DamagedEnemy->IsDead())
-				{
-					UGameplayStatics::ApplyDamage(
-					DamagedEnemy,
-					DamageAmount,
-					InstigatorVar,
-					this,
-					UDamageType::StaticClass());
-
-					// add to bots killed
-					if (DamagedEnemy->Health->GetHealth() <= 0)
-					{
-						(*BotKills)++;
-						(*BotTrueKills)++;
-
-						if (AControlPlayerState* ControlPlayerState = InstigatorVar->GetPlayerState<AControlPlayerState>())
-						{
-							ControlPlayerState->UpdateScore();
-						}
-					}
-
-					//Set up launch, decrease to airborne enemies
-					float LaunchForce = GrenadeKnockback;
-					if (!DamagedEnemy->GetMovementComponent()->IsMovingOnGround())
-					{
-						LaunchForce = LaunchForce / 1000;
-					}
-
-					DamagedEnemy->LaunchCharacter(EnemyLaunch * LaunchForce, true, false);
-				}
-			}
-
-			//deal damage to ally
-			else
-			{
-				// Damage effect
-				AMainCharacter* DamagedChar = Cast<AMainCharacter>(DamagedActor);
-				UY25_AbilitySystemComponent* AbilitySystemComponent = DamagedChar->GetAbilitySystemComponent();
-
-				if (!DamagedChar->GetIsDead())
-				{
-					FGameplayEffectContextHandle EffectContextHandle = AbilitySystemComponent->MakeEffectContext();
-					EffectContextHandle.AddSourceObject(this);
-
-					FGameplayEffectSpecHandle SpecHandle = AbilitySystemComponent->
-						MakeOutgoingSpec(DamageEffect, 1.f, EffectContextHandle);
-
-					if (SpecHandle.IsValid())
-					{
-						SpecHandle.Data->SetSetByCallerMagnitude(Y25::Tags::GameplayEffect_Health_Damaged, DamageAmount);
-						AbilitySystemComponent->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
-					}
-				}
-				
-				// knock back, less to airborne enemies
-				float LaunchForce = GrenadeKnockback;
-				if (!DamagedChar->GetMovementComponent()->IsMovingOnGround())
-				{
-					LaunchForce = LaunchForce / 1000;
-				}
-
-				DamagedChar->LaunchCharacter(EnemyLaunch * LaunchForce, true, false);
-			}
-		}
+		Explosions->Queue(Explosion);
 	}
-	Destroy();
+}
+
+UStaticMeshComponent* AGrenadeProjectile::GetGrenadeMesh() const
+{
+	return GrenadeMesh;
+}
+
+float AGrenadeProjectile::GetGravityScale() const
+{
+	return ProjectileMovementComponent ? ProjectileMovementComponent->ProjectileGravityScale : 1.0f;
 }
 
 void AGrenadeProjectile::LifeSpanExpired()
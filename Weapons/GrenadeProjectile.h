@@ -9,6 +9,23 @@
 
 #include "GrenadeProjectile.generated.h"
 
+//Everything needed to resolve a grenade blast without the grenade actor
+struct FGrenadeExplosion
+{
+	FVector Location = FVector::ZeroVector;
+	float Damage = 0;
+	float Radius = 0;
+	float FalloffMinScale = 1;
+	float Knockback = 0;
+	float BurnDamagePerSecond = 0;
+	float BurnDuration = 0;
+	TSubclassOf<UGameplayEffect> DamageEffect;
+	TWeakObjectPtr<AMainPlayerController> Instigator;
+	TWeakObjectPtr<AActor> DamageCauser;
+	//Left out of the blast, only ever the grenade actor itself so the thrower can still be hit
+	TWeakObjectPtr<AActor> IgnoredActor;
+};
+
 UCLASS()
 class Y25_API AGrenadeProjectile : public ABaseProjectile
 {
@@ -38,9 +55,35 @@ public:
 	UFUNCTION()
 	virtual void LifeSpanExpired() override;
 
+	//Blast using this grenade's stats at Location
+	FGrenadeExplosion MakeExplosion(const FVector& Location);
+
+	//Damage, knockback and effects for one blast, shared by grenade actors and simulated grenades.
+	//Resolved at the end of the frame together with any other blasts.
+	static void ResolveExplosion(UWorld* World, const FGrenadeExplosion& Explosion);
+
+	//Hit stats for the grenade touching OtherActor
+	static void RecordImpact(const AMainPlayerController* InstigatingPlayer, const AActor* OtherActor);
+
+	UStaticMeshComponent* GetGrenadeMesh() const;
+
+	float GetGravityScale() const;
+
 protected:
 	virtual void BeginPlay() override;
 
+private:
+	friend class UGrenadePoolSubsystem;
+	friend class UGrenadeSimulationSubsystem;
+
+	//Pool hooks, move into place and show, or hide and stop
+	void ActivateFromPool(const FTransform& Transform);
+
+	void DeactivateToPool();
+
+	//Player whose pool this grenade returns to, unset when spawned outside a pool
+	TWeakObjectPtr<AController> PoolPlayer;
+
 public:
 	UPROPERTY(EditDefaultsOnly, Category="Damage")
 	TSubclassOf<UGameplayEffect> DamageEffect;
@@ -52,17 +95,17 @@ private:
 	//Grenade stats
 	UPROPERTY(EditAnywhere, Category = "Bullet")
 	float DamageRadius = 500;
+	//Share of the damage left at the edge of the radius, 1 means no falloff
+	UPROPERTY(EditAnywhere, Category = "Bullet", meta = (ClampMin = 0, ClampMax = 1))
+	float DamageFalloffMinScale = 1;
+	//Enemies hit keep burning for BurnDuration seconds, 0 for no burn
+	UPROPERTY(EditAnywhere, Category = "Bullet", meta = (ClampMin = 0))
+	float BurnDamagePerSecond = 0;
+	UPROPERTY(EditAnywhere, Category = "Bullet", meta = (ClampMin = 0))
+	float BurnDuration = 0;
 	UPROPERTY(EditAnywhere, Category = "Bullet")
 	float GrenadeKnockback = 100;
 
 	UPROPERTY(EditAnywhere, Category = "Bullet")
 	TObjectPtr<AMainPlayerController> InstigatorVar;
-
-	void UpdateAccuracy();
-
-	int32* EnemyHits;
-	int32* FriendHits;
-	int32* BotKills;
-	float* FriendTrueHits;
-	float* BotTrueKills;
 };
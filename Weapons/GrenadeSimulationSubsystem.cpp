@@ -0,0 +1,253 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GrenadeSimulationSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+
+bool UGrenadeSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGrenadeSimulationSubsystem::Deinitialize()
+{
+	Positions.Empty();
+	Velocities.Empty();
+	MaxSpeeds.Empty();
+	Ages.Empty();
+	Damages.Empty();
+	Knockbacks.Empty();
+	Instigators.Empty();
+	Archetypes.Empty();
+	InstanceVisuals.Empty();
+	Visuals.Empty();
+	VisualTransforms.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UGrenadeSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGrenadeSimulationSubsystem, STATGROUP_Tickables);
+}
+
+int32 UGrenadeSimulationSubsystem::GetNumGrenades() const
+{
+	return Positions.Num();
+}
+
+void UGrenadeSimulationSubsystem::Launch(
+	const TSubclassOf<AGrenadeProjectile> GrenadeClass,
+	const FVector& Location,
+	const FVector& Velocity,
+	const float MaxSpeed,
+	const float Damage,
+	const float Knockback,
+	AMainPlayerController* InstigatingPlayer)
+{
+	if (!GrenadeClass)
+	{
+		return;
+	}
+
+	AGrenadeProjectile* Archetype = GrenadeClass->GetDefaultObject<AGrenadeProjectile>();
+
+	Positions.Add(Location);
+	Velocities.Add(Velocity);
+	MaxSpeeds.Add(MaxSpeed);
+	Ages.Add(0);
+	Damages.Add(Damage);
+	Knockbacks.Add(Knockback);
+	Instigators.Add(InstigatingPlayer);
+	Archetypes.Add(Archetype);
+	InstanceVisuals.Add(GetVisuals(Archetype));
+}
+
+void UGrenadeSimulationSubsystem::RemoveAt(const int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	MaxSpeeds.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Ages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Damages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Knockbacks.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Instigators.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Archetypes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	InstanceVisuals.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+FGrenadeExplosion UGrenadeSimulationSubsystem::MakeExplosion(const int32 Index, const FVector& Location) const
+{
+	//Radius and effects from the class, damage from the gun that fired it
+	FGrenadeExplosion Explosion = Archetypes[Index]->MakeExplosion(Location);
+	Explosion.Damage = Damages[Index];
+	Explosion.Knockback = Knockbacks[Index];
+	Explosion.Instigator = Instigators[Index];
+	//Pawn is only credited with the blast, there's no grenade actor to leave out
+	Explosion.DamageCauser = Instigators[Index].IsValid() ? Instigators[Index]->GetPawn() : nullptr;
+	Explosion.IgnoredActor = nullptr;
+	return Explosion;
+}
+
+void UGrenadeSimulationSubsystem::Tick(const float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UGrenadeSimulationSubsystem::Tick);
+
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	const float GravityZ = World->GetGravityZ();
+
+	//Backwards so removing swaps in a grenade that has already stepped
+	for (int32 Index = Positions.Num() - 1; Index >= 0; Index--)
+	{
+		//Out of time, explode in the air like LifeSpanExpired
+		Ages[Index] += DeltaTime;
+		if (Ages[Index] >= GrenadeLifeSpan)
+		{
+			PendingExplosions.Add(MakeExplosion(Index, Positions[Index]));
+			RemoveAt(Index);
+			continue;
+		}
+
+		const AGrenadeProjectile* Archetype = Archetypes[Index];
+		const UPrimitiveComponent* Hitbox = Archetype->HitboxCollision;
+
+		FVector& Velocity = Velocities[Index];
+		Velocity.Z += GravityZ * Archetype->GetGravityScale() * DeltaTime;
+		Velocity = Velocity.GetClampedToMaxSize(MaxSpeeds[Index]);
+
+		const FVector Start = Positions[Index];
+		const FVector End = Start + Velocity * DeltaTime;
+
+		//Grenades never hit the player who threw them
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GrenadeSimulation), false);
+		if (const AMainPlayerController* InstigatingPlayer = Instigators[Index].Get())
+		{
+			QueryParams.AddIgnoredActor(InstigatingPlayer->GetPawn());
+		}
+
+		//One sweep per grenade per step with the grenade's own collision
+		FHitResult HitResult;
+		if (World->SweepSingleByChannel(
+			HitResult,
+			Start,
+			End,
+			FQuat::Identity,
+			Hitbox->GetCollisionObjectType(),
+			Hitbox->GetCollisionShape(),
+			QueryParams,
+			FCollisionResponseParams(Hitbox->GetCollisionResponseToChannels())))
+		{
+			//Same rules as OnHit, grenades pass through each other
+			const AActor* OtherActor = HitResult.GetActor();
+			if (OtherActor && !OtherActor->IsA(AGrenadeProjectile::StaticClass()))
+			{
+				AGrenadeProjectile::RecordImpact(Instigators[Index].Get(), OtherActor);
+				PendingExplosions.Add(MakeExplosion(Index, HitResult.Location));
+				RemoveAt(Index);
+				continue;
+			}
+
+			//Nothing to explode on, rest against it until the timer runs out
+			if (!OtherActor)
+			{
+				Positions[Index] = HitResult.Location;
+				Velocity = FVector::ZeroVector;
+				continue;
+			}
+		}
+
+		Positions[Index] = End;
+	}
+
+	//Resolved after stepping so knockback can't move grenades mid-loop
+	for (const FGrenadeExplosion& Explosion : PendingExplosions)
+	{
+		AGrenadeProjectile::ResolveExplosion(World, Explosion);
+	}
+	PendingExplosions.Reset();
+
+	UpdateVisuals();
+}
+
+UInstancedStaticMeshComponent* UGrenadeSimulationSubsystem::GetVisuals(const AGrenadeProjectile* Archetype)
+{
+	const UStaticMeshComponent* GrenadeMesh = Archetype->GetGrenadeMesh();
+	UStaticMesh* StaticMesh = GrenadeMesh ? GrenadeMesh->GetStaticMesh() : nullptr;
+	if (!StaticMesh)
+	{
+		return nullptr;
+	}
+
+	if (const TObjectPtr<UInstancedStaticMeshComponent>* Existing = Visuals.Find(StaticMesh))
+	{
+		return *Existing;
+	}
+
+	//One actor holds every instanced mesh
+	if (!VisualsActor)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags = RF_Transient;
+		VisualsActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+	}
+
+	UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(VisualsActor);
+	Instances->SetStaticMesh(StaticMesh);
+	for (int32 Index = 0; Index < GrenadeMesh->GetNumMaterials(); Index++)
+	{
+		Instances->SetMaterial(Index, GrenadeMesh->GetMaterial(Index));
+	}
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+	Instances->SetMobility(EComponentMobility::Movable);
+
+	if (!VisualsActor->GetRootComponent())
+	{
+		VisualsActor->SetRootComponent(Instances);
+	}
+	Instances->RegisterComponent();
+
+	Visuals.Add(StaticMesh, Instances);
+	return Instances;
+}
+
+void UGrenadeSimulationSubsystem::UpdateVisuals()
+{
+	for (TPair<UInstancedStaticMeshComponent*, TArray<FTransform>>& Pair : VisualTransforms)
+	{
+		Pair.Value.Reset();
+	}
+
+	//Grenade mesh offset and scale, facing the way it's flying
+	for (int32 Index = 0; Index < Positions.Num(); Index++)
+	{
+		if (UInstancedStaticMeshComponent* Instances = InstanceVisuals[Index])
+		{
+			const FTransform Flight(Velocities[Index].Rotation(), Positions[Index]);
+			VisualTransforms.FindOrAdd(Instances).Add(
+				Archetypes[Index]->GetGrenadeMesh()->GetRelativeTransform() * Flight);
+		}
+	}
+
+	for (const TPair<UInstancedStaticMeshComponent*, TArray<FTransform>>& Pair : VisualTransforms)
+	{
+		UInstancedStaticMeshComponent* Instances = Pair.Key;
+		const TArray<FTransform>& Transforms = Pair.Value;
+
+		//Only rebuild when grenades were added or removed
+		if (Instances->GetInstanceCount() != Transforms.Num())
+		{
+			Instances->ClearInstances();
+			Instances->AddInstances(Transforms, false, true);
+		}
+		else if (Transforms.Num() > 0)
+		{
+			Instances->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+		}
+	}
+}
@@ -0,0 +1,80 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "Y25/Weapons/GrenadeProjectile.h"
+
+#include "GrenadeSimulationSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+//Steps grenades without actors. Each in-flight grenade is an entry in a set of parallel arrays and gets one sweep
+//per tick, explosions go through the same rules as AGrenadeProjectile and visuals are one instanced mesh per model.
+UCLASS()
+class Y25_API UGrenadeSimulationSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Start a grenade using GrenadeClass's collision, gravity, radius and mesh
+	void Launch(
+		TSubclassOf<AGrenadeProjectile> GrenadeClass,
+		const FVector& Location,
+		const FVector& Velocity,
+		float MaxSpeed,
+		float Damage,
+		float Knockback,
+		AMainPlayerController* InstigatingPlayer);
+
+	int32 GetNumGrenades() const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	void RemoveAt(int32 Index);
+
+	FGrenadeExplosion MakeExplosion(int32 Index, const FVector& Location) const;
+
+	void UpdateVisuals();
+
+	UInstancedStaticMeshComponent* GetVisuals(const AGrenadeProjectile* Archetype);
+
+	//Same as the grenade actor's lifespan
+	static constexpr float GrenadeLifeSpan = 5.0f;
+
+	//In-flight grenades, one entry per array
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> MaxSpeeds;
+	TArray<float> Ages;
+	TArray<float> Damages;
+	TArray<float> Knockbacks;
+	TArray<TWeakObjectPtr<AMainPlayerController>> Instigators;
+
+	//Class defaults the stats and collision come from
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AGrenadeProjectile>> Archetypes;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInstancedStaticMeshComponent>> InstanceVisuals;
+
+	//Explosions found while stepping, resolved once every grenade has moved
+	TArray<FGrenadeExplosion> PendingExplosions;
+
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> VisualsActor;
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UStaticMesh>, TObjectPtr<UInstancedStaticMeshComponent>> Visuals;
+
+	TMap<UInstancedStaticMeshComponent*, TArray<FTransform>> VisualTransforms;
+};
@@ -0,0 +1,173 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GrenadeTrajectoryComponent.h"
+
+#include "Engine/World.h"
+
+UGrenadeTrajectoryComponent::UGrenadeTrajectoryComponent()
+{
+	//Instances are placed in world space and only the owning player sees them
+	SetUsingAbsoluteLocation(true);
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetCanEverAffectNavigation(false);
+	SetCastShadow(false);
+	SetOnlyOwnerSee(true);
+	SetHiddenInGame(true);
+}
+
+bool UGrenadeTrajectoryComponent::HasLaunchChanged(
+	const FVector& Start,
+	const FVector& Velocity,
+	const float GravityZ) const
+{
+	if (!bHasPath || GravityZ != LastGravityZ || !FMath::IsNearlyEqual(Velocity.Size(), LastVelocity.Size()))
+	{
+		return true;
+	}
+
+	if (FVector::DistSquared(Start, LastStart) > FMath::Square(AimLocationThreshold))
+	{
+		return true;
+	}
+
+	const float CosAngle = Velocity.GetSafeNormal() | LastVelocity.GetSafeNormal();
+	return CosAngle < FMath::Cos(FMath::DegreesToRadians(AimAngleThreshold));
+}
+
+void UGrenadeTrajectoryComponent::UpdatePreview(
+	const FVector& Start,
+	const FVector& Velocity,
+	const float MaxSpeed,
+	const float GravityZ)
+{
+	//Finish the arc already in flight before starting another
+	if (!Traces.IsEmpty())
+	{
+		if (!ReadPath())
+		{
+			return;
+		}
+	}
+
+	if (HasLaunchChanged(Start, Velocity, GravityZ))
+	{
+		RequestPath(Start, Velocity, MaxSpeed, GravityZ);
+	}
+}
+
+void UGrenadeTrajectoryComponent::HidePreview()
+{
+	if (!bHasPath && Traces.IsEmpty())
+	{
+		return;
+	}
+
+	Traces.Reset();
+	bHasPath = false;
+	SetHiddenInGame(true);
+}
+
+void UGrenadeTrajectoryComponent::RequestPath(
+	const FVector& Start,
+	const FVector& Velocity,
+	const float MaxSpeed,
+	const float GravityZ)
+{
+	LastStart = Start;
+	LastVelocity = Velocity;
+	LastGravityZ = GravityZ;
+	bHasPath = true;
+
+	//Step the arc the same way the grenade moves, gravity then clamp to max speed
+	const int32 NumSteps = FMath::Max(FMath::CeilToInt32(MaxSimTime / TimeStep), 1);
+
+	Points.Reset(NumSteps + 1);
+	Points.Add(Start);
+
+	FVector Location = Start;
+	FVector StepVelocity = Velocity;
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		StepVelocity.Z += GravityZ * TimeStep;
+		StepVelocity = StepVelocity.GetClampedToMaxSize(MaxSpeed);
+		Location += StepVelocity * TimeStep;
+		Points.Add(Location);
+	}
+
+	//Every segment in one batch, read back next frame
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GrenadeTrajectory), false, GetOwner());
+	if (const AActor* Owner = GetOwner())
+	{
+		QueryParams.AddIgnoredActor(Owner->GetOwner());
+	}
+
+	Traces.Reset(NumSteps);
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		Traces.Add(GetWorld()->AsyncLineTraceByChannel(
+			EAsyncTraceType::Single,
+			Points[Step],
+			Points[Step + 1],
+			TraceChannel,
+			QueryParams));
+	}
+}
+
+bool UGrenadeTrajectoryComponent::ReadPath()
+{
+	const UWorld* World = GetWorld();
+
+	//The arc stops at the first segment that hits something
+	int32 NumPoints = Points.Num();
+	for (int32 Step = 0; Step < Traces.Num(); Step++)
+	{
+		FTraceDatum Datum;
+		if (!World->QueryTraceData(Traces[Step], Datum))
+		{
+			//Still running
+			if (World->IsTraceHandleValid(Traces[Step], false))
+			{
+				return false;
+			}
+			continue;
+		}
+
+		if (!Datum.OutHits.IsEmpty() && Datum.OutHits[0].bBlockingHit)
+		{
+			Points[Step + 1] = Datum.OutHits[0].Location;
+			NumPoints = Step + 2;
+			break;
+		}
+	}
+
+	Traces.Reset();
+	ShowPath(NumPoints);
+	return true;
+}
+
+void UGrenadeTrajectoryComponent::ShowPath(const int32 NumPoints)
+{
+	//One instance per point, facing along the arc
+	InstanceTransforms.Reset(NumPoints);
+	for (int32 Index = 0; Index < NumPoints; Index++)
+	{
+		const FVector Direction = Index + 1 < NumPoints
+			? Points[Index + 1] - Points[Index]
+			: Points[Index] - Points[FMath::Max(Index - 1, 0)];
+		InstanceTransforms.Emplace(Direction.Rotation(), Points[Index]);
+	}
+
+	if (GetInstanceCount() != InstanceTransforms.Num())
+	{
+		ClearInstances();
+		AddInstances(InstanceTransforms, false, true);
+	}
+	else
+	{
+		BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+
+	SetHiddenInGame(false);
+}
@@ -0,0 +1,64 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "WorldCollision.h"
+
+#include "GrenadeTrajectoryComponent.generated.h"
+
+//Grenade arc drawn as instances of the component's mesh in world space. The arc is only rebuilt when the launch
+//moves past the thresholds, and its collision traces run async so the game thread never waits on them.
+UCLASS(ClassGroup=(Y25), meta=(BlueprintSpawnableComponent))
+class Y25_API UGrenadeTrajectoryComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGrenadeTrajectoryComponent();
+
+	//Show the arc for a grenade launched from Start, rebuilt only if the launch changed enough
+	void UpdatePreview(const FVector& Start, const FVector& Velocity, float MaxSpeed, float GravityZ);
+
+	void HidePreview();
+
+protected:
+	//How far ahead the arc goes
+	UPROPERTY(EditAnywhere, Category="Trajectory", meta=(ClampMin=0))
+	float MaxSimTime = 2.0f;
+
+	//Time between arc points, one instance per point
+	UPROPERTY(EditAnywhere, Category="Trajectory", meta=(ClampMin=0.01))
+	float TimeStep = 0.05f;
+
+	//Aim has to turn this many degrees before the arc is rebuilt
+	UPROPERTY(EditAnywhere, Category="Trajectory", meta=(ClampMin=0))
+	float AimAngleThreshold = 1.0f;
+
+	//Or the muzzle has to move this far
+	UPROPERTY(EditAnywhere, Category="Trajectory", meta=(ClampMin=0))
+	float AimLocationThreshold = 10.0f;
+
+	UPROPERTY(EditAnywhere, Category="Trajectory")
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Visibility;
+
+private:
+	bool HasLaunchChanged(const FVector& Start, const FVector& Velocity, float GravityZ) const;
+
+	void RequestPath(const FVector& Start, const FVector& Velocity, float MaxSpeed, float GravityZ);
+
+	//False while traces are still in flight
+	bool ReadPath();
+
+	void ShowPath(int32 NumPoints);
+
+	TArray<FVector> Points;
+	TArray<FTraceHandle> Traces;
+	TArray<FTransform> InstanceTransforms;
+
+	//Launch the current arc was built from
+	FVector LastStart = FVector::ZeroVector;
+	FVector LastVelocity = FVector::ZeroVector;
+	float LastGravityZ = 0;
+	bool bHasPath = false;
+};
@@ -6,14 +6,23 @@
 #include "AbilitySystemGlobals.h"
 #include "CineCameraComponent.h"
 #include "EngineUtils.h"
+#include "Engine/AssetManager.h"
+#include "Misc/ConfigCacheIni.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSingleNodeInstance.h"
 #include "Components/AudioComponent.h"
 #include "Engine/World.h"
 #include "GameFramework/DamageType.h"
+#include "GameFramework/InputDeviceSubsystem.h"
 #include "GameplayCueManager.h"
 #include "GunTracerData.h"
 #include "TimerManager.h"
 #include "Engine/DamageEvents.h"
+#include "Y25/Combat/CombatMath.h"
+#include "Y25/Combat/EnemyHitboxComponent.h"
+#include "Y25/Combat/TargetIndexSubsystem.h"
+#include "Y25/Combat/WeakPointComponent.h"
 #include "Y25/Enemies/EnemySpawner/EnemySpawner.h"
 #include "Y25/Gameplay/Attributes/AttributeSet_Gun.h"
 #include "Y25/Gameplay/Cues.h"
@@ -23,9 +32,20 @@
 #include "AudioDevice.h"
 #include "Y25/Game/Control/ControlHUD.h"
 #include "Y25/Values/Collision.h"
+#include "Y25/Weapons/BallisticRoundSubsystem.h"
+#include "Y25/Weapons/GrenadePoolSubsystem.h"
+#include "Y25/Weapons/GrenadeSimulationSubsystem.h"
+#include "Y25/Weapons/GrenadeTrajectoryComponent.h"
+#include "Y25/Weapons/GunCueBudgetSubsystem.h"
+#include "Y25/Weapons/GunCueWarmupSubsystem.h"
+#include "Y25/Weapons/WeaponTraceSubsystem.h"
 
 DECLARE_LOG_CATEGORY_CLASS(LogGun, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("Y25 Gun"), STATGROUP_Y25Gun, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Aim Assist"), STAT_GunAimAssist, STATGROUP_Y25Gun);
+DECLARE_CYCLE_STAT(TEXT("Mesh Swap"), STAT_GunMeshSwap, STATGROUP_Y25Gun);
+
 //Stats
 namespace
 {
@@ -45,6 +65,20 @@ AGun::AGun()
 	GunMesh->SetCollisionResponseToChannel(ECC_Pawn, ECR_Overlap);
 	MagMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("MagMesh"));
 	MagMesh->SetupAttachment(GunMesh);
+	GrenadePreview = CreateDefaultSubobject<UGrenadeTrajectoryComponent>(TEXT("GrenadePreview"));
+	GrenadePreview->SetupAttachment(GunMesh);
+
+	//Config isn't loaded onto the object yet, read it directly to know which subobjects to make
+	if (GConfig)
+	{
+		GConfig->GetBool(TEXT("/Script/Y25.Gun"), TEXT("bUsePlayerAbilitySystem"), bUsePlayerAbilitySystem, GGameIni);
+	}
+
+	//Hosted guns find the player's ability system in BeginPlay
+	if (bUsePlayerAbilitySystem)
+	{
+		return;
+	}
 
 	//Ability System Component Set
 	AbilitySystemComponent = CreateDefaultSubobject<UAbilitySystemComponent>(TEXT("AbilitySystem"));
@@ -59,17 +93,44 @@ void AGun::BeginPlay()
 {
 	//Set Gun Type
 	Super::BeginPlay();
+
+	if (bUsePlayerAbilitySystem)
+	{
+		HostOnPlayerAbilitySystem();
+	}
+
+	if (bPreinstanceMeshes)
+	{
+		CreateMeshVariants();
+	}
+
+	if (!bUsePlayerAbilitySystem)
+	{
+		AbilitySystemComponent->InitAbilityActorInfo(this, this);
+	}
+
 	SetGunType(EGunType::Pistol);
 	SetAmmoType(EAmmoType::Bullet);
+	CaptureLoadoutSnapshot();
 
-	AbilitySystemComponent->InitAbilityActorInfo(this, this);
+	//Load cue notifies before the first shot needs them
+	if (UGunCueWarmupSubsystem* CueWarmup = GetWorld()->GetSubsystem<UGunCueWarmupSubsystem>())
+	{
+		CueWarmup->Warmup(GetCueTags());
+	}
 
+	FollowOwnerController();
 }
 
 void AGun::Tick(const float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	UpdateMeshSleep();
+
+	//Before recoil, so only the player's own look input is slowed
+	ApplyAimAssistSlowdown();
+
 	if (bRecoiling)
 	{
 		if (const AMainCharacter* CharacterOwner = Cast<AMainCharacter>(GetOwner()))
@@ -111,22 +172,26 @@ void AGun::Tick(const float DeltaTime)
 		RecoilDuration = FMath::Max(RecoilDuration - DeltaTime / 6, 0);
 	}
 
+	UpdateAimAssist(DeltaTime);
+
+	UpdateGrenadePreview();
+
 	//Aim gun towards the center of the screen, or object being aimed at
-	if (!GunMesh->IsPlaying())
+	if (!GetGunMesh()->IsPlaying())
 	{
 		const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
 
-		const float CurrentRange = GunAttributes->GetRange();
+		const float CurrentRange = GunAttributes ? GunAttributes->GetRange() : GetGunRange();
 
-		FMinimalViewInfo ViewInfo;
-		if (GetOwner())
-		{
-			GetOwner()->CalcCamera(0, ViewInfo);
-		}
-		else
+		const FVector AimStart = GetMuzzleTransform();
+		const FVector AimEnd = AimStart + GetActorRightVector() * CurrentRange;
+
+		//Traced with every other gun's this frame
+		if (UWeaponTraceSubsystem* WeaponTraces =
+			bBatchTraces ? GetWorld()->GetSubsystem<UWeaponTraceSubsystem>() : nullptr)
 		{
-			ViewInfo.Location = GetActorLocation();
-			ViewInfo.Rotation = GetActorRotation();
+			WeaponTraces->RequestAim(this, AimStart, AimEnd);
+			return;
 		}
 
 		FCollisionQueryParams QueryParams;
@@ -137,60 +202,612 @@ void AGun::Tick(const float DeltaTime)
 		FHitResult HitResult;
 		GetWorld()->LineTraceSingleByChannel(
 			HitResult,
-			GetMuzzleTransform(),
-			GetMuzzleTransform() + GetActorRightVector() * CurrentRange,
+			AimStart,
+			AimEnd,
 			Y25::Collision::Channels::Weapon,
 			QueryParams);
 
-		const float NotLaserRange = FVector::Dist(HitResult.Location, ViewInfo.Location) + 1;
+		ApplyAimTrace(HitResult);
+	}
+}
+
+void AGun::ApplyAimTrace(const FHitResult& HitResult)
+{
+	const FMinimalViewInfo ViewInfo = GetOwnerViewInfo();
+
+	const float NotLaserRange = FVector::Dist(HitResult.Location, ViewInfo.Location) + 1;
 
-		FVector ReturnLocation = ViewInfo.Location + ViewInfo.Rotation.Vector() * NotLaserRange;
+	FVector ReturnLocation = ViewInfo.Location + ViewInfo.Rotation.Vector() * NotLaserRange;
+
+	if (HitResult.IsValidBlockingHit())
+	{
+		ReturnLocation = HitResult.ImpactPoint;
+	}
 
-		if (HitResult.IsValidBlockingHit())
+	//Calc Viewport
+	if (const AActor* Actor = GetOwner())
+	{
+		if (const AMainPlayerController* MainPlayerController =
+			Cast<AMainPlayerController>(Actor->GetInstigatorController()))
 		{
-			ReturnLocation = HitResult.ImpactPoint;
+			int32 ScreenX;
+			int32 ScreenY;
+			MainPlayerController->GetViewportSize(ScreenX, ScreenY);
+
+			const float CenterScreenX = ScreenX / 2;
+			const float CenterScreenY = ScreenY / 2;
+
+			FVector2D ScreenLocation;
+
+			MainPlayerController->ProjectWorldLocationToScreen(ReturnLocation, ScreenLocation, true);
+
+			//If the gun is facing to far off center, adjust value
+			if (ScreenLocation.X > CenterScreenX)
+			{
+				XOffset -= .02;
+			}
+			else
+			{
+				XOffset += .02;
+			}
+			if (ScreenLocation.Y > CenterScreenY)
+			{
+				YOffset -= .02;
+			}
+			else
+			{
+				YOffset += .02;
+			}
 		}
+	}
+}
+
+bool AGun::CanPlayCue(const EGunCuePriority Priority, const FVector& Location) const
+{
+	UGunCueBudgetSubsystem* CueBudget = GetWorld()->GetSubsystem<UGunCueBudgetSubsystem>();
+	return !CueBudget || CueBudget->TryPlay(Priority, Location);
+}
 
-		//Calc Viewport
-		if (const AActor* Actor = GetOwner())
+FGameplayTagContainer AGun::GetCueTags() const
+{
+	FGameplayTagContainer CueTags;
+	CueTags.AddTag(Y25::Cues::Gun_Tracer);
+	CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Other);
+	CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Crit);
+	CueTags.AddTag(Y25::Cues::Gun_AmmoHit_EnemySpawner);
+
+	TArray<EAmmoType> AmmoTypes;
+	AmmoValues.GetKeys(AmmoTypes);
+	AmmoTypes.AddUnique(GetAmmoType());
+
+	for (const EAmmoType Ammo : AmmoTypes)
+	{
+		switch (Ammo)
 		{
-			if (const AMainPlayerController* MainPlayerController =
-				Cast<AMainPlayerController>(Actor->GetInstigatorController()))
+		case EAmmoType::Bullet:
+			CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Bullet);
+			break;
+		case EAmmoType::Piercing:
+			CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Laser);
+			break;
+		case EAmmoType::Chain:
+			CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Chain);
+			break;
+		case EAmmoType::Grenade:
+			CueTags.AddTag(Y25::Cues::Gun_AmmoTrail_Grenade);
+			CueTags.AddTag(Y25::Cues::Gun_AmmoHit_Grenade);
+			break;
+		}
+	}
+
+	return CueTags;
+}
+
+//Camera view of the player holding the gun
+FMinimalViewInfo AGun::GetOwnerViewInfo() const
+{
+	FMinimalViewInfo ViewInfo;
+	if (GetOwner())
+	{
+		GetOwner()->CalcCamera(0, ViewInfo);
+	}
+	else
+	{
+		ViewInfo.Location = GetActorLocation();
+		ViewInfo.Rotation = GetActorRotation();
+	}
+	return ViewInfo;
+}
+
+FVector AGun::GetGrenadeLaunchVelocity(const FVector& AimPoint) const
+{
+	const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+	if (!GunAttributes)
+	{
+		return FVector::ZeroVector;
+	}
+
+	return (GetMuzzleTransform() - AimPoint).Rotation().Vector() * GunAttributes->GetBulletSpeed();
+}
+
+void AGun::UpdateGrenadePreview()
+{
+	//Only the local player with grenade ammo sees the arc
+	const APawn* PawnOwner = Cast<APawn>(GetOwner());
+	if (GetAmmoType() != EAmmoType::Grenade || !GrenadeClass || !PawnOwner || !PawnOwner->IsLocallyControlled())
+	{
+		GrenadePreview->HidePreview();
+		return;
+	}
+
+	const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+	if (!GunAttributes)
+	{
+		GrenadePreview->HidePreview();
+		return;
+	}
+
+	//Same view trace SpawnGrenade aims with, without spread so the arc holds still
+	const FVector AimPoint = GetSpreadPoint(false);
+
+	const float GravityZ =
+		GetWorld()->GetGravityZ() * GrenadeClass->GetDefaultObject<AGrenadeProjectile>()->GetGravityScale();
+
+	GrenadePreview->UpdatePreview(
+		GetMuzzleTransform(),
+		GetGrenadeLaunchVelocity(AimPoint),
+		GunAttributes->GetBulletSpeed(),
+		GravityZ);
+}
+
+void AGun::ApplyAimAssistSlowdown()
+{
+	if (!AimAssistLastRotation.IsSet() || AimAssistLookScale >= 1)
+	{
+		return;
+	}
+
+	//Whatever turned the view since the gun last set it was the player's look input, scale it down
+	const AMainCharacter* CharacterOwner = Cast<AMainCharacter>(GetOwner());
+	AController* Controller = CharacterOwner ? CharacterOwner->GetController() : nullptr;
+	if (!Controller)
+	{
+		return;
+	}
+
+	const FRotator LastRotation = AimAssistLastRotation.GetValue();
+	const FRotator LookDelta = (Controller->GetControlRotation() - LastRotation).GetNormalized();
+	Controller->SetControlRotation(LastRotation + LookDelta * AimAssistLookScale);
+}
+
+void AGun::UpdateAimAssist(const float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GunAimAssist);
+
+	AimAssistTarget = nullptr;
+	AimAssistLookScale = 1.0f;
+	AimAssistLastRotation.Reset();
+
+	if (!bAimAssistEnabled)
+	{
+		return;
+	}
+
+	//Only local players on a gamepad get assist, mouse aim is left alone
+	const AMainCharacter* CharacterOwner = Cast<AMainCharacter>(GetOwner());
+	APlayerController* PlayerController =
+		CharacterOwner ? Cast<APlayerController>(CharacterOwner->GetController()) : nullptr;
+	if (!PlayerController || !PlayerController->IsLocalController())
+	{
+		return;
+	}
+
+	const UInputDeviceSubsystem* InputDevices = UInputDeviceSubsystem::Get();
+	if (!InputDevices ||
+		InputDevices->GetMostRecentlyUsedHardwareDevice(PlayerController->GetPlatformUserId()).PrimaryDeviceType !=
+		EHardwareDevicePrimaryType::Gamepad)
+	{
+		return;
+	}
+
+	const FMinimalViewInfo ViewInfo = GetOwnerViewInfo();
+
+	FCollisionQueryParams QueryParams;
+	QueryParams.AddIgnoredActor(this);
+	QueryParams.AddIgnoredActor(GetOwner());
+
+	if (APawn* BestTarget = FindAimAssistTarget(
+		GetWorld(),
+		ViewInfo,
+		AimAssistConeAngle,
+		GetGunRange(),
+		QueryParams,
+		AimAssistCandidates))
+	{
+		AimAssistTarget = BestTarget;
+
+		//Slowdown only once the aim ray passes within CapRadius of the target
+		const FVector ToTarget = BestTarget->GetActorLocation() - ViewInfo.Location;
+		if (FVector::CrossProduct(ToTarget, ViewInfo.Rotation.Vector()).Size() <= CapRadius)
+		{
+			AimAssistLookScale = AimAssistSlowdown;
+		}
+
+		//Magnetism, pull the aim towards the target while aiming
+		if (bAiming && AimAssistMagnetism > 0)
+		{
+			const FRotator CurrentRotation = PlayerController->GetControlRotation();
+			const FRotator Delta = (ToTarget.Rotation() - CurrentRotation).GetNormalized();
+			const float MaxStep = AimAssistMagnetism * DeltaTime;
+
+			PlayerController->SetControlRotation(CurrentRotation + FRotator(
+				FMath::Clamp(Delta.Pitch, -MaxStep, MaxStep),
+				FMath::Clamp(Delta.Yaw, -MaxStep, MaxStep),
+				0));
+		}
+	}
+
+	//Next frame's slowdown measures look input from here
+	AimAssistLastRotation = PlayerController->GetControlRotation();
+}
+
+APawn* AGun::FindAimAssistTarget(
+	const UWorld* World,
+	const FMinimalViewInfo& ViewInfo,
+	const float ConeAngleDegrees,
+	const float Range,
+	const FCollisionQueryParams& QueryParams,
+	TArray<APawn*>& Candidates)
+{
+	const UTargetIndexSubsystem* TargetIndex = World->GetSubsystem<UTargetIndexSubsystem>();
+	if (!TargetIndex)
+	{
+		return nullptr;
+	}
+
+	//Cheap view cone over living enemies, no physics
+	const FVector ViewDirection = ViewInfo.Rotation.Vector();
+	TargetIndex->QueryCone(
+		ViewInfo.Location,
+		ViewDirection,
+		FMath::DegreesToRadians(ConeAngleDegrees),
+		Range,
+		Candidates,
+		ETargetKind::Enemy);
+
+	//Best target is the one closest to the aim ray
+	APawn* BestTarget = nullptr;
+	double BestCos = -1;
+	for (APawn* Candidate : Candidates)
+	{
+		if (const double Cos = FVector::DotProduct(
+			ViewDirection,
+			(Candidate->GetActorLocation() - ViewInfo.Location).GetSafeNormal()); Cos > BestCos)
+		{
+			BestTarget = Candidate;
+			BestCos = Cos;
+		}
+	}
+
+	if (!BestTarget)
+	{
+		return nullptr;
+	}
+
+	//Confirm only the best target can actually be seen
+	FHitResult HitResult;
+	World->LineTraceSingleByChannel(
+		HitResult,
+		ViewInfo.Location,
+		BestTarget->GetActorLocation(),
+		Y25::Collision::Channels::Weapon,
+		QueryParams);
+
+	if (HitResult.bBlockingHit && HitResult.GetActor() != BestTarget)
+	{
+		return nullptr;
+	}
+
+	return BestTarget;
+}
+
+APawn* AGun::GetAimAssistTarget() const
+{
+	return AimAssistTarget;
+}
+
+//Ammo trail struct
+void AGun::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//The player's ability system outlives the gun, take this gun's effects and attributes back off it
+	if (bUsePlayerAbilitySystem && IsValid(AbilitySystemComponent))
+	{
+		for (const FActiveGameplayEffectHandle& Handle :
+			{GunGameplayEffect, GunModGameplayEffect, PureModPlayEffect, AmmoGameplayEffect})
+		{
+			if (Handle.IsValid())
 			{
-				int32 ScreenX;
-				int32 ScreenY;
-				MainPlayerController->GetViewportSize(ScreenX, ScreenY);
+				AbilitySystemComponent->RemoveActiveGameplayEffect(Handle);
+			}
+		}
 
-				const float CenterScreenX = ScreenX / 2;
-				const float CenterScreenY = ScreenY / 2;
+		if (AttributeSet_Gun && HasAuthority())
+		{
+			AbilitySystemComponent->RemoveSpawnedAttribute(AttributeSet_Gun);
+		}
 
-				FVector2D ScreenLocation;
+		//Client stand-in that the server's set never replaced
+		if (LocalAttributeSet)
+		{
+			AbilitySystemComponent->RemoveSpawnedAttribute(LocalAttributeSet);
+			LocalAttributeSet = nullptr;
+		}
+	}
 
-				MainPlayerController->ProjectWorldLocationToScreen(ReturnLocation, ScreenLocation, true);
+	for (TSharedPtr<FStreamableHandle>& Handle : PrefetchHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+	PrefetchHandles.Empty();
+	GunMeshHandle.Reset();
+	MagMeshHandle.Reset();
+	MeshVariantsHandle.Reset();
 
-				//If the gun is facing to far off center, adjust value
-				if (ScreenLocation.X > CenterScreenX)
-				{
-					XOffset -= .02;
-				}
-				else
-				{
-					XOffset += .02;
-				}
-				if (ScreenLocation.Y > CenterScreenY)
-				{
-					YOffset -= .02;
-				}
-				else
-				{
-					YOffset += .02;
-				}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGun::CaptureLoadoutSnapshot()
+{
+	LoadoutSnapshot.GunType = GunType;
+	LoadoutSnapshot.AmmoType = AmmoType;
+	LoadoutSnapshot.AttributeBases.Reset();
+
+	//Base values already include anything instant, the gun and ammo effects stay active through a reset
+	TArray<FGameplayAttribute> Attributes;
+	UAttributeSet::GetAttributesFromSetClass(UAttributeSet_Gun::StaticClass(), Attributes);
+	for (const FGameplayAttribute& Attribute : Attributes)
+	{
+		LoadoutSnapshot.AttributeBases.Emplace(Attribute, AbilitySystemComponent->GetNumericAttributeBase(Attribute));
+	}
+}
+
+void AGun::ActivateFromPool(AActor* NewOwner)
+{
+	SetOwner(NewOwner);
+	SetInstigator(Cast<APawn>(NewOwner));
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+
+	bMeshesAwake = true;
+	MeshWakeStartTime = GetWorld()->GetTimeSeconds();
+	GetGunMesh()->SetComponentTickEnabled(true);
+	GetMagMesh()->SetComponentTickEnabled(true);
+
+	ResetToLoadoutSnapshot();
+	FollowOwnerController();
+
+	//Parking cleared the wait for the server's attributes
+	if (LocalAttributeSet)
+	{
+		GetWorldTimerManager().SetTimer(
+			ReplicatedSetTimerHandle,
+			this,
+			&AGun::ResolveReplicatedAttributeSet,
+			0.1f,
+			true);
+	}
+}
+
+void AGun::DeactivateToPool()
+{
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	//Lambda timers aren't bound to the gun, so they're cut off by generation instead
+	PoolGeneration++;
+
+	//Rounds and shots in flight would land with no owner to credit
+	if (UBallisticRoundSubsystem* BallisticRounds = GetWorld()->GetSubsystem<UBallisticRoundSubsystem>())
+	{
+		BallisticRounds->CancelRounds(this);
+	}
+	if (UWeaponTraceSubsystem* WeaponTraces = GetWorld()->GetSubsystem<UWeaponTraceSubsystem>())
+	{
+		WeaponTraces->CancelRequests(this);
+	}
+
+	//Hidden meshes still update their pose unless stopped
+	bMeshesAwake = false;
+	GetGunMesh()->SetComponentTickEnabled(false);
+	GetMagMesh()->SetComponentTickEnabled(false);
+
+	//The dead character shouldn't be kept around through the gun
+	SetOwner(nullptr);
+	SetInstigator(nullptr);
+}
+
+void AGun::ResetToLoadoutSnapshot()
+{
+	//Hosted on the old character's ability system, which died with it, so set up from scratch on the new one
+	if (bUsePlayerAbilitySystem && (!IsValid(AbilitySystemComponent) || !IsValid(AbilitySystemComponent->GetOwner())))
+	{
+		GunGameplayEffect = AmmoGameplayEffect = GunModGameplayEffect = PureModPlayEffect = FActiveGameplayEffectHandle();
+		EffectSpecs.Reset();
+		LocalAttributeSet = nullptr;
+		StatusEffectTimes.Empty();
+		CurrentMods.Empty();
+		SwapGunStats.Empty();
+
+		HostOnPlayerAbilitySystem();
+		SetGunType(LoadoutSnapshot.GunType);
+		SetAmmoType(LoadoutSnapshot.AmmoType);
+		CaptureLoadoutSnapshot();
+		return;
+	}
+
+	//Mods from the last life
+	for (FActiveGameplayEffectHandle* Handle : {&GunModGameplayEffect, &PureModPlayEffect})
+	{
+		if (Handle->IsValid())
+		{
+			AbilitySystemComponent->RemoveActiveGameplayEffect(*Handle);
+			*Handle = FActiveGameplayEffectHandle();
+		}
+	}
+
+	//Anything else on the gun's own ability system, like ship effects, is from the last life too
+	if (!bUsePlayerAbilitySystem)
+	{
+		for (const FActiveGameplayEffectHandle& Handle : AbilitySystemComponent->GetActiveEffects(FGameplayEffectQuery()))
+		{
+			if (Handle != GunGameplayEffect && Handle != AmmoGameplayEffect)
+			{
+				AbilitySystemComponent->RemoveActiveGameplayEffect(Handle);
 			}
 		}
 	}
+
+	CurrentMods.Empty();
+	SwapGunStats.Empty();
+	StatusEffectTimes.Empty();
+
+	//Only a gun that ended its last life on another gun or ammo type needs those effects again
+	if (GunType != LoadoutSnapshot.GunType)
+	{
+		SetGunType(LoadoutSnapshot.GunType);
+	}
+	if (AmmoType != LoadoutSnapshot.AmmoType)
+	{
+		SetAmmoType(LoadoutSnapshot.AmmoType);
+	}
+
+	for (const TPair<FGameplayAttribute, float>& AttributeBase : LoadoutSnapshot.AttributeBases)
+	{
+		AbilitySystemComponent->SetNumericAttributeBase(AttributeBase.Key, AttributeBase.Value);
+	}
+
+	bRecoiling = false;
+	RecoilDuration = 0;
+	bPromptReload = false;
+	SetAiming(false);
+	SetReloading(false);
+	SetCanFire(true);
+
+	//The new character's camera and HUD only need telling once
+	if (AMainCharacter* MainCharacter = Cast<AMainCharacter>(GetOwner()))
+	{
+		MainCharacter->UpdateCameraEnd(GunType == EGunType::SniperRifle);
+		OnReticleChange.Broadcast(GetGunMeshIndex(GunType));
+	}
+	UpdateMagazineSize();
+}
+
+void AGun::HostOnPlayerAbilitySystem()
+{
+	//Same ability system the player controller hands out, or the character's
+	UAbilitySystemComponent* PlayerAbilitySystem = nullptr;
+	if (AMainCharacter* MainCharacter = Cast<AMainCharacter>(GetOwner()))
+	{
+		if (AMainPlayerController* MainPlayerController = Cast<AMainPlayerController>(MainCharacter->GetController()))
+		{
+			PlayerAbilitySystem = MainPlayerController->GetAbilitySystemComponent();
+		}
+		if (!PlayerAbilitySystem)
+		{
+			PlayerAbilitySystem = MainCharacter->GetAbilitySystemComponent();
+		}
+	}
+
+	//No player to host on, give the gun its own like before
+	if (!PlayerAbilitySystem)
+	{
+		bUsePlayerAbilitySystem = false;
+
+		//Server makes it and it replicates to clients with the gun, so clients never end up with two
+		if (!HasAuthority())
+		{
+			AbilitySystemComponent = FindComponentByClass<UAbilitySystemComponent>();
+		}
+		if (AbilitySystemComponent)
+		{
+			return;
+		}
+
+		AbilitySystemComponent = NewObject<UAbilitySystemComponent>(this, TEXT("AbilitySystem"));
+		//A client only gets here when the server hosted on a player, so its own copy stays local
+		AbilitySystemComponent->SetIsReplicated(HasAuthority());
+		AbilitySystemComponent->SetReplicationMode(EGameplayEffectReplicationMode::Full);
+		AbilitySystemComponent->RegisterComponent();
+		AddInstanceComponent(AbilitySystemComponent);
+
+		AttributeSet_Gun = NewObject<UAttributeSet_Gun>(this, TEXT("AttributeSet.Gun"));
+		AbilitySystemComponent->AddSpawnedAttribute(AttributeSet_Gun);
+		return;
+	}
+
+	AbilitySystemComponent = PlayerAbilitySystem;
+
+	//One gun per player, a set already there is the server's replicated one or another gun's
+	if (const UAttributeSet_Gun* ExistingSet = PlayerAbilitySystem->GetSet<UAttributeSet_Gun>())
+	{
+		ensureMsgf(
+			!HasAuthority(),
+			TEXT("%s is hosting gun attributes on %s, which already has them"),
+			*GetName(),
+			*GetNameSafe(PlayerAbilitySystem->GetOwner()));
+		AttributeSet_Gun = const_cast<UAttributeSet_Gun*>(ExistingSet);
+		return;
+	}
+
+	AttributeSet_Gun = NewObject<UAttributeSet_Gun>(PlayerAbilitySystem->GetOwner());
+	PlayerAbilitySystem->AddSpawnedAttribute(AttributeSet_Gun);
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	//Clients read their own until the server's arrives, which replaces the whole list and drops this one
+	LocalAttributeSet = AttributeSet_Gun;
+	GetWorldTimerManager().SetTimer(
+		ReplicatedSetTimerHandle,
+		this,
+		&AGun::ResolveReplicatedAttributeSet,
+		0.1f,
+		true);
+}
+
+void AGun::ResolveReplicatedAttributeSet()
+{
+	if (!LocalAttributeSet || !IsValid(AbilitySystemComponent))
+	{
+		GetWorldTimerManager().ClearTimer(ReplicatedSetTimerHandle);
+		return;
+	}
+
+	for (UAttributeSet* Set : AbilitySystemComponent->GetSpawnedAttributes())
+	{
+		UAttributeSet_Gun* ReplicatedSet = Cast<UAttributeSet_Gun>(Set);
+		if (!ReplicatedSet || ReplicatedSet == LocalAttributeSet)
+		{
+			continue;
+		}
+
+		//Stand-in is normally gone already, take it off in case the server's arrived alongside it
+		AbilitySystemComponent->RemoveSpawnedAttribute(LocalAttributeSet);
+		LocalAttributeSet = nullptr;
+		AttributeSet_Gun = ReplicatedSet;
+		GetWorldTimerManager().ClearTimer(ReplicatedSetTimerHandle);
+		return;
+	}
 }
 
-//Ammo trail struct
 void AGun::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
@@ -260,6 +877,7 @@ void AGun::UpdateAccuracy() const
 }
 
 void AGun::CheckEnemyHit(
+	const EAmmoType AmmoType,
 	FVector& LaunchDirection,
 	FHitResult HitResult,
 	FGameplayTag EffectTag,
@@ -275,7 +893,7 @@ void AGun::CheckEnemyHit(
 
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
 	
-	if (!HitEnemy && !HitAlly && !HitSpawner)
+	if (!HitEnemy && !HitAlly && !HitSpawner && CanPlayCue(EGunCuePriority::Miss, HitResult.ImpactPoint))
 	{
 		CueParam.Location = HitResult.ImpactPoint;
 		UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
@@ -289,41 +907,82 @@ void AGun::CheckEnemyHit(
 		//Ammo hit and damage to enemies
 		CueParam.SourceObject = HitEnemy;
 		CueParam.Location = HitResult.ImpactPoint;
-		UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
-			HitEnemy,
-			EffectTag,
-			CueParam);
 
-		if (GetAmmoType() == EAmmoType::Chain)
+		if (AmmoType == EAmmoType::Chain)
 		{
 			ChainBounce(HitEnemy, LaunchDirection);
 		}
 		
 		float Damage = MyAttributes->GetBulletDamage();
-	
-		if (const USkeletalMeshComponent* EnemyMesh = HitEnemy->GetMesh())
+
+		//Hitbox proxies don't report a bone themselves
+		HitResult.BoneName = UEnemyHitboxComponent::GetHitBone(HitResult);
+
+		//Check for a hit on one of the enemy's weak points
+		float CritMultiplier = 0;
+		if (const UWeakPointComponent* WeakPoints = HitEnemy->FindComponentByClass<UWeakPointComponent>())
+		{
+			if (const FWeakPoint* WeakPoint = WeakPoints->FindWeakPoint(HitResult))
+			{
+				CritMultiplier = WeakPoint->DamageMultiplier;
+			}
+		}
+		//Enemies without weak points use the crit socket
+		else if (const USkeletalMeshComponent* EnemyMesh = HitEnemy->GetMesh())
+		{
+			if (FVector::Dist(HitResult.ImpactPoint, EnemyMesh->GetSocketLocation("Critical")) <= GetCriticalDistance())
+			{
+				CritMultiplier = GetCritDamageMultiplier();
+			}
+		}
+
+		if (CritMultiplier > 0)
+		{
+			Damage *= CritMultiplier;
+		}
+
+		//Only the shooter hears hit confirms
+		if (const APawn* PawnOwner = Cast<APawn>(GetOwner()); PawnOwner && PawnOwner->IsLocallyControlled())
+		{
+			if (UGunAudioSubsystem* GunAudio = GetWorld()->GetSubsystem<UGunAudioSubsystem>())
+			{
+				GunAudio->HitConfirm(this);
+			}
+		}
+
+		//Killing blows and crits keep their effects when cues are over budget
+		const EGunCuePriority HitPriority = Damage >= HitEnemy->Health->GetHealth()
+			? EGunCuePriority::Kill
+			: CritMultiplier > 0 ? EGunCuePriority::Crit : EGunCuePriority::Hit;
+
+		if (CanPlayCue(HitPriority, HitResult.ImpactPoint))
 		{
-			//Check for hit close enough to the crit point on an enemy
-			if (const float CritDistance = FVector::Dist(HitResult.ImpactPoint, EnemyMesh->GetSocketLocation("Critical"));
-				CritDistance <= GetCriticalDistance())
+			UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
+				HitEnemy,
+				EffectTag,
+				CueParam);
+		}
+
+		if (CritMultiplier > 0)
+		{
+			//Deal crit damage + activate crit effects
+			if (CanPlayCue(FMath::Max(HitPriority, EGunCuePriority::Crit), HitResult.ImpactPoint))
 			{
-				//Deal crit damage + activate crit effects
 				UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
 					HitEnemy,
 					Y25::Cues::Gun_AmmoHit_Crit,
 					CueParam);
+			}
 
-				Damage *= GetCritDamageMultiplier();
-				GetStat(CriticalHitsStat)++;
-				GetTrueStat(TEXT("Critical Hits"))++;
+			GetStat(CriticalHitsStat)++;
+			GetTrueStat(TEXT("Critical Hits"))++;
 
-				if (const AMainCharacter* MainCharacter = Cast<AMainCharacter>(GetOwner()))
+			if (const AMainCharacter* MainCharacter = Cast<AMainCharacter>(GetOwner()))
+			{
+				if (AControlPlayerState* ControlPlayerState =
+					Cast<AControlPlayerState>(MainCharacter->GetPlayerState()))
 				{
-					if (AControlPlayerState* ControlPlayerState =
-						Cast<AControlPlayerState>(MainCharacter->GetPlayerState()))
-					{
-						ControlPlayerState->UpdateScore();
-					}
+					ControlPlayerState->UpdateScore();
 				}
 			}
 		}
@@ -359,13 +1018,16 @@ void AGun::CheckEnemyHit(
 		//On hit effect
 		CueParam.SourceObject = HitAlly;
 		CueParam.Location = HitAlly->GetActorLocation();
-		UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
-			HitAlly,
-			EffectTag,
-			CueParam);
+		if (CanPlayCue(EGunCuePriority::Hit, CueParam.Location))
+		{
+			UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
+				HitAlly,
+				EffectTag,
+				CueParam);
+		}
 
 		//Bounce to multiple enemies if chain ammo
-		if (GetAmmoType() == EAmmoType::Chain)
+		if (AmmoType == EAmmoType::Chain)
 		{
 			ChainBounce(HitAlly, LaunchDirection);
 		}
@@ -380,7 +1042,7 @@ void AGun::CheckEnemyHit(
 		}
 	}
 
-	if (HitSpawner)
+	if (HitSpawner && CanPlayCue(EGunCuePriority::Hit, HitResult.Location))
 	{
 		CueParam.SourceObject = HitSpawner;
 		CueParam.Location = HitResult.Location;
@@ -411,8 +1073,10 @@ void AGun::SetGunType(const EGunType NewType)
 			1,
 			GunContextHandle);
 
-		const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
-		SetGunRange(GunAttributes->GetRange());
+		if (const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>())
+		{
+			SetGunRange(GunAttributes->GetRange());
+		}
 	}
 
 	if (!SwapGunStats.IsEmpty())
@@ -446,28 +1110,8 @@ void AGun::SetGunType(const EGunType NewType)
 	if (AMainCharacter* MainCharacter = Cast<AMainCharacter>(GetOwner()))
 	{
 		//Switch Meshes, also change camera on the sniper for correct zoom
-		int8 Index;
-		switch (NewType)
-		{
-		case EGunType::Pistol:
-			Index = 0;
-			MainCharacter->UpdateCameraEnd(false);
-			break;
-		case EGunType::Gatling:
-			Index = 1;
-			MainCharacter->UpdateCameraEnd(false);
-			break;
-		case EGunType::Shotgun:
-			Index = 2;
-			MainCharacter->UpdateCameraEnd(false);
-			break;
-		case EGunType::SniperRifle:
-			Index = 3;
-			MainCharacter->UpdateCameraEnd(true);
-			break;
-		default:
-			Index = 0;
-		}
+		const int8 Index = GetGunMeshIndex(NewType);
+		MainCharacter->UpdateCameraEnd(NewType == EGunType::SniperRifle);
 
 		ChangeGunMesh(Index);
 		OnReticleChange.Broadcast(Index);
@@ -548,33 +1192,17 @@ void AGun::SetAmmoType(const EAmmoType NewAmmo)
 	UpdateMagazineSize();
 
 	//Update Ammo Mesh
-	switch (NewAmmo)
-	{
-	case EAmmoType::Bullet:
-		ChangeMagMesh(0);
-		break;
-	case EAmmoType::Piercing:
-		ChangeMagMesh(1);
-		break;
-	case EAmmoType::Chain:
-		ChangeMagMesh(2);
-		break;
-	case EAmmoType::Grenade:
-		ChangeMagMesh(3);
-		break;
-	default:
-		ChangeMagMesh(0);
-	}
+	ChangeMagMesh(GetMagMeshIndex(NewAmmo));
 }
 
-USkeletalMeshComponent* AGun::GetGunMesh()
+USkeletalMeshComponent* AGun::GetGunMesh() const
 {
-	return GunMesh;
+	return ActiveGunMesh ? ActiveGunMesh : GunMesh;
 }
 
-USkeletalMeshComponent* AGun::GetMagMesh()
+USkeletalMeshComponent* AGun::GetMagMesh() const
 {
-	return MagMesh;
+	return ActiveMagMesh ? ActiveMagMesh : MagMesh;
 }
 
 void AGun::SetReloadTime(const float NewTime)
@@ -639,6 +1267,11 @@ float AGun::GetChainBounceRange() const
 	return ChainBounceRange;
 }
 
+int32 AGun::GetChainForkCount() const
+{
+	return FMath::Max(ChainForkCount, 1);
+}
+
 float AGun::GetCritDamageMultiplier() const
 {
 	return CritDamageMultiplier;
@@ -675,7 +1308,7 @@ int32 AGun::GetCurrentMagazineMaxReserves() const
 
 bool AGun::CanFire() const
 {
-	return bCanFire;
+	return bCanFire && !bGunMeshLoading;
 }
 
 void AGun::SetCanFire(const bool CanFire)
@@ -691,6 +1324,11 @@ bool AGun::GetReloading() const
 void AGun::SetReloading(const bool Reloading)
 {
 	bReloading = Reloading;
+
+	if (Reloading)
+	{
+		WakeMeshes();
+	}
 }
 
 void AGun::SetAiming(const bool Aiming)
@@ -699,25 +1337,376 @@ void AGun::SetAiming(const bool Aiming)
 }
 #pragma endregion
 
-//Gun Visual Function
-void AGun::ChangeGunMesh(const int8 Index)
+//Gun Visual Function
+int8 AGun::GetGunMeshIndex(const EGunType Type)
+{
+	switch (Type)
+	{
+	case EGunType::Gatling:
+		return 1;
+	case EGunType::Shotgun:
+		return 2;
+	case EGunType::SniperRifle:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+int8 AGun::GetMagMeshIndex(const EAmmoType Ammo)
+{
+	switch (Ammo)
+	{
+	case EAmmoType::Piercing:
+		return 1;
+	case EAmmoType::Chain:
+		return 2;
+	case EAmmoType::Grenade:
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+//Equipped meshes load ahead of everything else and replace the handle of the mesh they swap out, releasing it.
+//OnLoaded runs once the mesh is set, or right away when it was already loaded.
+static void StreamMesh(
+	USkeletalMeshComponent* MeshComponent,
+	const TSoftObjectPtr<USkeletalMesh>& Mesh,
+	TSharedPtr<FStreamableHandle>& Handle,
+	TFunction<void()> OnLoaded = nullptr)
+{
+	if (USkeletalMesh* LoadedMesh = Mesh.Get())
+	{
+		MeshComponent->SetSkeletalMesh(LoadedMesh);
+		if (OnLoaded)
+		{
+			OnLoaded();
+		}
+	}
+
+	//Only the latest swap sets its mesh when it finishes
+	TWeakObjectPtr WeakMeshComponent(MeshComponent);
+	const TSharedPtr<FStreamableHandle> PreviousHandle = Handle;
+	Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		Mesh.ToSoftObjectPath(),
+		[WeakMeshComponent, Mesh, OnLoaded = MoveTemp(OnLoaded)]
+		{
+			if (!WeakMeshComponent.IsValid())
+			{
+				return;
+			}
+
+			USkeletalMesh* LoadedMesh = Mesh.Get();
+			if (LoadedMesh && WeakMeshComponent->GetSkeletalMeshAsset() != LoadedMesh)
+			{
+				WeakMeshComponent->SetSkeletalMesh(LoadedMesh);
+			}
+
+			//A failed load still has to let go, the old mesh is all there is
+			if (OnLoaded)
+			{
+				OnLoaded();
+			}
+		},
+		FStreamableManager::AsyncLoadHighPriority);
+
+	if (PreviousHandle.IsValid())
+	{
+		PreviousHandle->CancelHandle();
+	}
+}
+
+void AGun::ChangeGunMesh(const int8 Index)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GunMeshSwap);
+
+	if (GunMeshVariants.IsValidIndex(Index))
+	{
+		SwapMeshVariant(ActiveGunMesh, GunMeshVariants[Index], GunMesh);
+	}
+	else if (GunMeshes.IsValidIndex(Index))
+	{
+		//The old mesh's muzzle socket is in the wrong place for the new gun, hold fire until it swaps
+		bGunMeshLoading = true;
+		TWeakObjectPtr WeakThis(this);
+		StreamMesh(GunMesh, GunMeshes[Index], GunMeshHandle, [WeakThis]
+		{
+			if (WeakThis.IsValid())
+			{
+				WeakThis->bGunMeshLoading = false;
+			}
+		});
+	}
+
+	WakeMeshes();
+}
+
+void AGun::ChangeMagMesh(const int8 Index)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GunMeshSwap);
+
+	if (MagMeshVariants.IsValidIndex(Index))
+	{
+		SwapMeshVariant(ActiveMagMesh, MagMeshVariants[Index], MagMesh);
+	}
+	else if (MagMeshes.IsValidIndex(Index))
+	{
+		StreamMesh(MagMesh, MagMeshes[Index], MagMeshHandle);
+	}
+
+	WakeMeshes();
+}
+
+void AGun::CreateMeshVariants()
+{
+	//The gun's own mesh components stay as empty attach points
+	auto CreateVariants = [this](
+		USkeletalMeshComponent* Template,
+		const int32 Count,
+		TArray<TObjectPtr<USkeletalMeshComponent>>& Variants)
+	{
+		for (int32 Index = 0; Index < Count; Index++)
+		{
+			USkeletalMeshComponent* Variant = NewObject<USkeletalMeshComponent>(this, NAME_None, RF_Transient);
+			Variant->SetupAttachment(GunMesh);
+			Variant->SetRelativeTransform(Template == GunMesh ? FTransform::Identity : Template->GetRelativeTransform());
+			Variant->SetAnimationMode(Template->GetAnimationMode());
+			Variant->SetAnimInstanceClass(Template->AnimClass);
+			//Shown variant takes over the template's collision, see SwapMeshVariant
+			Variant->SetCollisionObjectType(Template->GetCollisionObjectType());
+			Variant->SetCollisionResponseToChannels(Template->GetCollisionResponseToChannels());
+			Variant->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+			Variant->SetVisibility(false);
+			Variant->SetComponentTickEnabled(false);
+			Variant->RegisterComponent();
+			Variants.Add(Variant);
+		}
+		Template->SetSkeletalMesh(nullptr);
+	};
+	CreateVariants(GunMesh, GunMeshes.Num(), GunMeshVariants);
+	CreateVariants(MagMesh, MagMeshes.Num(), MagMeshVariants);
+
+	//Every mesh is set once here while hidden, instead of on each swap. The handle keeps all of them resident for
+	//the gun's lifetime, streaming equipped meshes only applies without bPreinstanceMeshes
+	TWeakObjectPtr WeakThis(this);
+	auto SetVariantMeshes = [WeakThis]
+	{
+		if (!WeakThis.IsValid())
+		{
+			return;
+		}
+
+		auto SetMeshes = [](
+			const TArray<TSoftObjectPtr<USkeletalMesh>>& Meshes,
+			const TArray<TObjectPtr<USkeletalMeshComponent>>& Variants)
+		{
+			for (int32 Index = 0; Index < Variants.Num(); Index++)
+			{
+				USkeletalMesh* Mesh = Meshes[Index].Get();
+				if (Mesh && !Variants[Index]->GetSkeletalMeshAsset())
+				{
+					Variants[Index]->SetSkeletalMesh(Mesh);
+				}
+			}
+		};
+		SetMeshes(WeakThis->GunMeshes, WeakThis->GunMeshVariants);
+		SetMeshes(WeakThis->MagMeshes, WeakThis->MagMeshVariants);
+	};
+	SetVariantMeshes();
+
+	TArray<FSoftObjectPath> MeshPaths;
+	for (const TSoftObjectPtr<USkeletalMesh>& Mesh : GunMeshes)
+	{
+		MeshPaths.Add(Mesh.ToSoftObjectPath());
+	}
+	for (const TSoftObjectPtr<USkeletalMesh>& Mesh : MagMeshes)
+	{
+		MeshPaths.Add(Mesh.ToSoftObjectPath());
+	}
+	MeshVariantsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		MeshPaths,
+		SetVariantMeshes,
+		FStreamableManager::AsyncLoadHighPriority);
+}
+
+void AGun::SwapMeshVariant(
+	TObjectPtr<USkeletalMeshComponent>& Active,
+	USkeletalMeshComponent* Next,
+	const USkeletalMeshComponent* Template)
+{
+	if (Active == Next)
+	{
+		return;
+	}
+
+	bool bVisible = true;
+	if (Active)
+	{
+		bVisible = Active->IsVisible();
+
+		//Carry over the playing animation when the new mesh shares the skeleton
+		const USkeleton* NextSkeleton =
+			Next->GetSkeletalMeshAsset() ? Next->GetSkeletalMeshAsset()->GetSkeleton() : nullptr;
+		if (const UAnimSingleNodeInstance* Playing = Active->GetSingleNodeInstance(); Playing && Playing->IsPlaying())
+		{
+			UAnimationAsset* Animation = Playing->GetAnimationAsset();
+			if (Animation && Animation->GetSkeleton() == NextSkeleton)
+			{
+				Next->PlayAnimation(Animation, Playing->IsLooping());
+				Next->SetPlayRate(Playing->GetPlayRate());
+				Next->SetPosition(Playing->GetCurrentTime(), false);
+			}
+		}
+		else if (UAnimInstance* ActiveAnim = Active->GetAnimInstance())
+		{
+			UAnimMontage* Montage = ActiveAnim->GetCurrentActiveMontage();
+			UAnimInstance* NextAnim = Next->GetAnimInstance();
+			if (Montage && NextAnim && Montage->GetSkeleton() == NextSkeleton)
+			{
+				NextAnim->Montage_Play(
+					Montage,
+					ActiveAnim->Montage_GetPlayRate(Montage),
+					EMontagePlayReturnType::MontageLength,
+					ActiveAnim->Montage_GetPosition(Montage));
+			}
+		}
+
+		Active->SetVisibility(false);
+		Active->SetComponentTickEnabled(false);
+		Active->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+
+	//The template has no mesh left to collide with, so the shown variant carries its collision
+	Next->SetVisibility(bVisible);
+	Next->SetComponentTickEnabled(true);
+	Next->SetCollisionEnabled(Template->GetCollisionEnabled());
+	Active = Next;
+}
+
+void AGun::WakeMeshes()
+{
+	if (!bSleepIdleMeshes)
+	{
+		return;
+	}
+
+	MeshWakeStartTime = GetWorld()->GetTimeSeconds();
+	if (bMeshesAwake)
+	{
+		return;
+	}
+
+	bMeshesAwake = true;
+	GetGunMesh()->SetComponentTickEnabled(true);
+	GetMagMesh()->SetComponentTickEnabled(true);
+}
+
+void AGun::UpdateMeshSleep()
+{
+	if (!bSleepIdleMeshes || !bMeshesAwake || GetWorld()->GetTimeSeconds() - MeshWakeStartTime < MeshWakeTime)
+	{
+		return;
+	}
+
+	for (const USkeletalMeshComponent* Mesh : {GetGunMesh(), GetMagMesh()})
+	{
+		const UAnimInstance* AnimInstance = Mesh->GetAnimInstance();
+		if (Mesh->IsPlaying() || (AnimInstance && AnimInstance->IsAnyMontagePlaying()))
+		{
+			return;
+		}
+	}
+
+	//The last pose stays on screen, attachment still moves the meshes with the player
+	bMeshesAwake = false;
+	GetGunMesh()->SetComponentTickEnabled(false);
+	GetMagMesh()->SetComponentTickEnabled(false);
+}
+
+//Swap cost should stay flat however many times guns swap, compare with and without preinstanced meshes
+static FAutoConsoleCommandWithWorldAndArgs GunSwapBenchmarkCommand(
+	TEXT("Y25.Gun.SwapBenchmark"),
+	TEXT("Swap every gun's meshes N times (default 100) and log the average and worst swap"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Count = FMath::Max(Args.IsEmpty() ? 100 : FCString::Atoi(*Args[0]), 1);
+		for (TActorIterator<AGun> It(World); It; ++It)
+		{
+			AGun* Gun = *It;
+			double TotalTime = 0;
+			double WorstTime = 0;
+			for (int32 Swap = 0; Swap < Count; Swap++)
+			{
+				//Cycle through a mesh per gun type
+				const double StartTime = FPlatformTime::Seconds();
+				Gun->ChangeGunMesh(Swap % 4);
+				Gun->ChangeMagMesh(Swap % 4);
+				const double SwapTime = FPlatformTime::Seconds() - StartTime;
+
+				TotalTime += SwapTime;
+				WorstTime = FMath::Max(WorstTime, SwapTime);
+			}
+
+			Gun->ChangeGunMesh(AGun::GetGunMeshIndex(Gun->GetGunType()));
+			Gun->ChangeMagMesh(AGun::GetMagMeshIndex(Gun->GetAmmoType()));
+
+			UE_LOG(
+				LogGun,
+				Log,
+				TEXT("%s swapped %d times: %.1f us average, %.1f us worst"),
+				*Gun->GetName(),
+				Count,
+				TotalTime / Count * 1000000,
+				WorstTime * 1000000);
+		}
+	}));
+
+void AGun::PrefetchLoadout(const EGunType NextGunType, const EAmmoType NextAmmoType)
 {
-	if (GunMeshes.IsValidIndex(Index))
+	const int8 GunIndex = GetGunMeshIndex(NextGunType);
+	const int8 MagIndex = GetMagMeshIndex(NextAmmoType);
+
+	TArray<FSoftObjectPath> MeshPaths;
+	if (GunMeshes.IsValidIndex(GunIndex))
 	{
-		GunMesh->SetSkeletalMesh(GunMeshes[Index]);
+		MeshPaths.Add(GunMeshes[GunIndex].ToSoftObjectPath());
+	}
+	if (MagMeshes.IsValidIndex(MagIndex))
+	{
+		MeshPaths.Add(MagMeshes[MagIndex].ToSoftObjectPath());
 	}
-}
 
-void AGun::ChangeMagMesh(const int8 Index)
-{
-	if (MagMeshes.IsValidIndex(Index))
+	if (MeshPaths.IsEmpty() || MaxPrefetchedLoadouts == 0)
+	{
+		return;
+	}
+
+	PrefetchHandles.Add(UAssetManager::GetStreamableManager().RequestAsyncLoad(MeshPaths));
+
+	//Release the oldest prefetches, anything still equipped stays loaded through its own handle
+	while (PrefetchHandles.Num() > MaxPrefetchedLoadouts)
 	{
-		MagMesh->SetSkeletalMesh(MagMeshes[Index]);
+		if (PrefetchHandles[0].IsValid())
+		{
+			PrefetchHandles[0]->ReleaseHandle();
+		}
+		PrefetchHandles.RemoveAt(0);
 	}
 }
 
 //Gun Functions
 
+const FGunShotAudio& AGun::GetShotAudio() const
+{
+	return ShotAudio;
+}
+
+bool AGun::IsShotAudioHandled() const
+{
+	return ShotAudio.ShotSound != nullptr;
+}
+
 FVector AGun::GetMuzzleTransform() const
 {
 	//Get location to shoot from via socket
@@ -740,12 +1729,16 @@ FVector AGun::GetMuzzleTransform() const
 		SocketName = "barrelEndPistol";
 	}
 
-	return GunMesh->GetSocketLocation(SocketName);
+	return GetGunMesh()->GetSocketLocation(SocketName);
 }
 
 void AGun::UpdateMagazineSize()
 {
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+	if (!MyAttributes)
+	{
+		return;
+	}
 
 	//Update values based on GAS
 	SetCurrentClipSize(MyAttributes->GetMagSize());
@@ -766,6 +1759,8 @@ void AGun::UpdateMagazineSize()
 
 void AGun::ReloadGun()
 {
+	WakeMeshes();
+
 	//Get the possible maximum amount of bullets you should grab
 	const int32 MaxToGrab = GetCurrentClipSize() - GetCurrentNumBullets();
 	const int32 BulletsGrabbed = FMath::Min(static_cast<int32>(GetCurrentReserves()), MaxToGrab);
@@ -843,7 +1838,12 @@ void AGun::ShootGun()
 		return;
 	}
 
+	//Attributes haven't reached this client yet
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+	if (!MyAttributes)
+	{
+		return;
+	}
 
 	// recoil
 	if (const AMainCharacter* CharacterOwner = Cast<AMainCharacter>(GetOwner()))
@@ -865,7 +1865,15 @@ void AGun::ShootGun()
 		}
 	}
 
+	WakeMeshes();
 	OnShootAnim.Broadcast();
+	if (IsShotAudioHandled())
+	{
+		if (UGunAudioSubsystem* GunAudio = GetWorld()->GetSubsystem<UGunAudioSubsystem>())
+		{
+			GunAudio->Shot(this);
+		}
+	}
 	SetCanFire(false);
 	SetReloading(true);
 
@@ -875,9 +1883,9 @@ void AGun::ShootGun()
 	
 	GetWorldTimerManager().SetTimer(
 		FireDelayTimerHandle,
-		[WeakThis]
+		[WeakThis, Generation = PoolGeneration]
 		{
-			if (!WeakThis.IsValid())
+			if (!WeakThis.IsValid() || WeakThis->PoolGeneration != Generation)
 			{
 				return;
 			}
@@ -906,6 +1914,10 @@ void AGun::ShootGun()
 
 	FVector TraceStart = GetMuzzleTransform();
 
+	//Every pellet of this shot goes into the frame's trace batch, sharing one camera trace
+	UWeaponTraceSubsystem* WeaponTraces =
+		bBatchTraces && !bBallisticRounds ? GetWorld()->GetSubsystem<UWeaponTraceSubsystem>() : nullptr;
+
 	for (int i = 0; i < NumFired; i++)
 	{
 		GetStat(ShotsFiredStat)++;
@@ -917,7 +1929,10 @@ void AGun::ShootGun()
 		case EAmmoType::Bullet:
 		case EAmmoType::Piercing:
 		case EAmmoType::Chain:
-			LineTrace(TraceStart);
+			if (!WeaponTraces)
+			{
+				LineTrace(TraceStart);
+			}
 			break;
 		case EAmmoType::Grenade:
 			SpawnGrenade(TraceStart);
@@ -926,27 +1941,65 @@ void AGun::ShootGun()
 			break;
 		}
 	}
+
+	if (WeaponTraces && GetAmmoType() != EAmmoType::Grenade)
+	{
+		WeaponTraces->RequestShot(this, MakeShotRequest(TraceStart, NumFired));
+	}
 }
 
-FVector AGun::GetSpreadPoint() const
+FWeaponShotRequest AGun::MakeShotRequest(const FVector& TraceStart, const int32 NumPellets) const
 {
 	const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
 
-	//Bullet spread and range
-	const float CurrentSpreadAngle = FMath::DegreesToRadians(GunAttributes->GetSpreadAngle());
-	const float CurrentRange = GunAttributes->GetRange();
+	const FMinimalViewInfo ViewInfo = GetOwnerViewInfo();
+
+	//Same inputs GetSpreadPoint and LineTrace read
+	FWeaponShotRequest Shot;
+	Shot.Muzzle = TraceStart;
+	Shot.GunLocation = GetActorLocation();
+	Shot.ViewLocation = ViewInfo.Location;
+	Shot.ViewDirection = ViewInfo.Rotation.Vector();
+	Shot.SpreadHalfAngle = FMath::DegreesToRadians(GunAttributes->GetSpreadAngle());
+	Shot.Range = GunAttributes->GetRange();
+	Shot.PierceRange = GetGunRange();
+	Shot.NumPellets = NumPellets;
+	Shot.AmmoType = GetAmmoType();
+	Shot.Seed = FMath::Rand();
+	return Shot;
+}
 
-	//Get Camera view
-	FMinimalViewInfo ViewInfo;
-	if (GetOwner())
-	{
-		GetOwner()->CalcCamera(0, ViewInfo);
-	}
-	else
+void AGun::ApplyShotTrace(
+	const EAmmoType AmmoType,
+	FVector Direction,
+	const FHitResult& Hit,
+	const TArray<FHitResult>& PierceHits)
+{
+	switch (AmmoType)
 	{
-		ViewInfo.Location = GetActorLocation();
-		ViewInfo.Rotation = GetActorRotation();
+	case EAmmoType::Piercing:
+		LaserLineTraceEffect(Direction, PierceHits);
+		break;
+	case EAmmoType::Bullet:
+	case EAmmoType::Chain:
+		ResolveBulletChainHit(AmmoType, GetMuzzleTransform(), Direction, Hit);
+		break;
+	default:
+		break;
 	}
+}
+
+FVector AGun::GetSpreadPoint(const bool bApplySpread) const
+{
+	const UAttributeSet_Gun* GunAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+
+	//Bullet spread and range
+	const float CurrentSpreadAngle =
+		GunAttributes && bApplySpread ? FMath::DegreesToRadians(GunAttributes->GetSpreadAngle()) : 0;
+	const float CurrentRange = GunAttributes ? GunAttributes->GetRange() : GetGunRange();
+
+	//Get Camera view
+	const FMinimalViewInfo ViewInfo = GetOwnerViewInfo();
 
 	//Prepare line trace
 	FCollisionQueryParams QueryParams;
@@ -1016,6 +2069,20 @@ void AGun::LineTrace(const FVector& TraceStart)
 	//Bullet and chain are a single line trace with pawns blocking
 	case EAmmoType::Bullet:
 	case EAmmoType::Chain:
+		//Round travels and lands on a later tick
+		if (UBallisticRoundSubsystem* BallisticRounds = GetWorld()->GetSubsystem<UBallisticRoundSubsystem>();
+			BallisticRounds && bBallisticRounds)
+		{
+			BallisticRounds->Fire(
+				this,
+				GetAmmoType(),
+				TraceStart,
+				LaunchDirection * BallisticSpeed,
+				GetGunRange(),
+				BallisticGravityScale);
+			break;
+		}
+
 		ResponseParams.CollisionResponse.SetResponse(Y25::Collision::Channels::Pawn, ECR_Block);
 
 		GetWorld()->LineTraceSingleByChannel(
@@ -1038,26 +2105,38 @@ void AGun::LineTrace(const FVector& TraceStart)
 
 void AGun::BulletChainLineTraceEffect(FVector& LaunchDirection, const FHitResult& Hit)
 {
-	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+	ResolveBulletChainHit(GetAmmoType(), GetMuzzleTransform(), LaunchDirection, Hit);
+}
 
+void AGun::PlayBulletTracer(const EAmmoType AmmoType, const FVector& Muzzle, const FVector& Impact)
+{
+	TracerData->MuzzlePosition = Muzzle;
+	TracerData->AmmoType = AmmoType;
+	TracerData->bShotAudioHandled = IsShotAudioHandled();
+	TracerData->GunMesh = GetGunMesh();
+	TracerData->ImpactPositions = {Impact};
+	if (CanPlayCue(EGunCuePriority::Tracer, TracerData->MuzzlePosition))
 	{
-		// Create tracer effect
-		TracerData->MuzzlePosition = GetMuzzleTransform();
-		TracerData->AmmoType = GetAmmoType();
-		TracerData->GunMesh = GunMesh;
-		if (Hit.bBlockingHit)
-		{
-			TracerData->ImpactPositions = {Hit.ImpactPoint};
-		}
-		else
-		{
-			TracerData->ImpactPositions = {GetMuzzleTransform() + LaunchDirection * MyAttributes->GetRange()};
-		}
 		Gameplay::Cue(Y25::Cues::Gun_Tracer)
 			.Instigator(GetInstigator())
 			.SourceObject(TracerData)
 			.Execute(this);
 	}
+}
+
+void AGun::ResolveBulletChainHit(
+	const EAmmoType AmmoType,
+	const FVector& Muzzle,
+	FVector& LaunchDirection,
+	const FHitResult& Hit)
+{
+	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
+
+	// Create tracer effect
+	PlayBulletTracer(
+		AmmoType,
+		Muzzle,
+		Hit.bBlockingHit ? FVector(Hit.ImpactPoint) : Muzzle + LaunchDirection * MyAttributes->GetRange());
 
 	//Did it hit someone
 	if (!IsValid(Hit.GetActor()))
@@ -1067,7 +2146,7 @@ void AGun::BulletChainLineTraceEffect(FVector& LaunchDirection, const FHitResult
 
 	//Check if chain ammo
 	FGameplayTag EffectTag;
-	if (GetAmmoType() == EAmmoType::Bullet)
+	if (AmmoType == EAmmoType::Bullet)
 	{
 		EffectTag = Y25::Cues::Gun_AmmoHit_Bullet;
 	}
@@ -1076,104 +2155,210 @@ void AGun::BulletChainLineTraceEffect(FVector& LaunchDirection, const FHitResult
 		EffectTag = Y25::Cues::Gun_AmmoHit_Chain;
 	}
 
-	CheckEnemyHit(LaunchDirection, Hit, EffectTag);
+	CheckEnemyHit(AmmoType, LaunchDirection, Hit, EffectTag);
+}
+
+void AGun::OnBallisticRoundHit(
+	const EAmmoType AmmoType,
+	const FVector& Origin,
+	FVector Direction,
+	const FHitResult& Hit)
+{
+	//Spent in the air, only the tracer out to where it gave out
+	if (!Hit.bBlockingHit)
+	{
+		PlayBulletTracer(AmmoType, Origin, Hit.TraceEnd);
+		return;
+	}
+
+	//Same tracer and hit rules as an instant bullet, from where it was fired
+	ResolveBulletChainHit(AmmoType, Origin, Direction, Hit);
 }
 
 void AGun::ChainBounce(APawn* HitEnemy, FVector& LaunchDirection)
 {
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
 
-	//How many bounces and who has been hit?
-	float RemainingBounces = MyAttributes->GetNumBounces();
-	TSet<APawn*> CollidedTargets = TSet<APawn*>();
-	CollidedTargets.Add(HitEnemy);
+	ChainBounceHelper({}, HitEnemy, MyAttributes->GetNumBounces(), LaunchDirection);
+}
+
+void AGun::ChainBounceHelper(
+	const TSet<APawn*> CollidedTargets,
+	APawn* HitEnemy,
+	const float RemainingBounces,
+	FVector LaunchDirection)
+{
+	//Only enemies start a chain, and only with bounces left
+	const int32 NumBounces = FMath::CeilToInt32(RemainingBounces);
+	if (!HitEnemy || !HitEnemy->IsA(ABaseEnemy::StaticClass()) || NumBounces <= 0)
+	{
+		return;
+	}
+
+	//Plan every hop up front so the chain only queries once
+	const TSharedRef<TArray<FChainHop>> ChainPath = MakeShared<TArray<FChainHop>>();
+	PlanChainPath(HitEnemy, NumBounces, *ChainPath, CollidedTargets);
+
+	if (ChainPath->IsEmpty())
+	{
+		return;
+	}
 
-	FTimerHandle ChainDelayTimer;
 	TWeakObjectPtr WeakThis = this;
 
-	//Small timer for non-near instant bounce
-	GetWorldTimerManager().SetTimer(
-		ChainDelayTimer,
-		[WeakThis, CollidedTargets, HitEnemy, RemainingBounces, LaunchDirection]()
-		{
-			if (!WeakThis.IsValid()) {return;}
-			
-			WeakThis->ChainBounceHelper(CollidedTargets, HitEnemy, RemainingBounces, LaunchDirection);
-		},
-		0.2f,
-		false);
+	//Small timer per depth for non-near instant bounces
+	const int32 MaxDepth = ChainPath->Last().Depth;
+	for (int32 Depth = 1; Depth <= MaxDepth; Depth++)
+	{
+		FTimerHandle ChainDelayTimer;
+		GetWorldTimerManager().SetTimer(
+			ChainDelayTimer,
+			[WeakThis, ChainPath, Depth, NumBounces, Generation = PoolGeneration]
+			{
+				if (!WeakThis.IsValid() || WeakThis->PoolGeneration != Generation) {return;}
+
+				WeakThis->ChainBounceHops(*ChainPath, Depth, NumBounces);
+			},
+			0.2f * Depth,
+			false);
+	}
 }
 
-void AGun::ChainBounceHelper(TSet<APawn*> CollidedTargets, APawn* HitEnemy, float RemainingBounces, FVector LaunchDirection)
+void AGun::ChainBounceHops(const TArray<FChainHop>& ChainPath, const int32 Depth, const int32 NumBounces)
 {
 	if (IsPendingKillPending() || !IsValid(this) || !IsValid(AbilitySystemComponent)) {return;}
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
 
-	//check hit an enemy and still have bounces left
-	if (!HitEnemy || !HitEnemy->IsA(ABaseEnemy::StaticClass()) || RemainingBounces <= 0)
-	{
-		return;
-	}
-
-	//Get new target
-	ABaseEnemy* BounceTarget = FindNearestPawn(
-		GetChainBounceRange(),
-		HitEnemy->GetActorLocation(),
-		CollidedTargets);
+	//Less Damage based on number of bounces
+	const int32 RemainingBounces = NumBounces - Depth;
+	const float BounceDamage = MyAttributes->GetBulletDamage() / pow(2, 5 - RemainingBounces);
 
-	//If valid
-	if (BounceTarget)
+	for (const FChainHop& Hop : ChainPath)
 	{
-		//Update bounces left and who's been hit
-		RemainingBounces--;
-		CollidedTargets.Add(BounceTarget);
+		if (Hop.Depth != Depth)
+		{
+			continue;
+		}
+
+		//Targets may have died or despawned since the chain was planned
+		APawn* HitEnemy = Hop.Source.Get();
+		ABaseEnemy* BounceTarget = Hop.Target.Get();
+		if (!HitEnemy || !BounceTarget || BounceTarget->IsDead())
+		{
+			continue;
+		}
 
 		{
 			// Create tracer effect
 			TracerData->MuzzlePosition = HitEnemy->GetActorLocation();
-			TracerData->AmmoType = GetAmmoType();
-			TracerData->GunMesh = GunMesh;
+			TracerData->AmmoType = EAmmoType::Chain;
+			TracerData->bShotAudioHandled = IsShotAudioHandled();
+			TracerData->GunMesh = GetGunMesh();
 			TracerData->ImpactPositions = {BounceTarget->GetActorLocation()};
 
-			Gameplay::Cue(Y25::Cues::Gun_Tracer)
-				.Instigator(GetInstigator())
-				.SourceObject(TracerData)
-				.Execute(BounceTarget);
+			if (CanPlayCue(EGunCuePriority::Tracer, TracerData->MuzzlePosition))
+			{
+				Gameplay::Cue(Y25::Cues::Gun_Tracer)
+					.Instigator(GetInstigator())
+					.SourceObject(TracerData)
+					.Execute(BounceTarget);
+			}
 		}
 
 		FGameplayCueParameters CueParam;
 		CueParam.Instigator = GetOwner();
 		CueParam.SourceObject = HitEnemy;
 		CueParam.Location = BounceTarget->GetActorLocation();
-		UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
-			BounceTarget,
-			Y25::GameplayCues::Gun_AmmoHit_Chain,
-			CueParam);
+		if (CanPlayCue(EGunCuePriority::Hit, CueParam.Location))
+		{
+			UAbilitySystemGlobals::Get().GetGameplayCueManager()->ExecuteGameplayCue_NonReplicated(
+				BounceTarget,
+				Y25::GameplayCues::Gun_AmmoHit_Chain,
+				CueParam);
+		}
 
-		//Less Damage based on number of bounces
-		DealDamage(
-			MyAttributes->GetBulletDamage() / pow(2, 5 - RemainingBounces), BounceTarget);
+		DealDamage(BounceDamage, BounceTarget);
 	}
-	//If invalid target
-	else
+}
+
+void AGun::PlanChainPath(
+	APawn* HitEnemy,
+	const int32 NumBounces,
+	TArray<FChainHop>& OutPath,
+	const TSet<APawn*>& ExcludedTargets) const
+{
+	OutPath.Reset();
+
+	const FVector Origin = HitEnemy->GetActorLocation();
+	const float HopRange = GetChainBounceRange();
+
+	//One query covering every hop the chain could possibly reach
+	const UTargetIndexSubsystem* TargetIndex = GetWorld()->GetSubsystem<UTargetIndexSubsystem>();
+	if (!TargetIndex)
 	{
 		return;
 	}
 
-	//Repeat if targets available and bounces left
-	FTimerHandle ChainDelayHelperTimer;
-	TWeakObjectPtr WeakThis = this;
+	TArray<APawn*> InRange;
+	TargetIndex->QueryRadius(Origin, HopRange * NumBounces, InRange, ETargetKind::Enemy);
 
-	GetWorldTimerManager().SetTimer(
-		ChainDelayHelperTimer,
-		[WeakThis, CollidedTargets, BounceTarget, RemainingBounces, LaunchDirection]
+	//Index only returns living enemies, skip the first target
+	TArray<ABaseEnemy*, TInlineAllocator<32>> Candidates;
+	Y25::CombatMath::FPositionsSoA CandidateLocations;
+	CandidateLocations.Reset(InRange.Num());
+	for (APawn* Pawn : InRange)
+	{
+		if (Pawn == HitEnemy || ExcludedTargets.Contains(Pawn))
 		{
-			if (!WeakThis.IsValid()) {return;}
-			
-			WeakThis->ChainBounceHelper(CollidedTargets, BounceTarget, RemainingBounces, LaunchDirection);
-		},
-		.2f,
-		false);
+			continue;
+		}
+		Candidates.Add(static_cast<ABaseEnemy*>(Pawn));
+		CandidateLocations.Add(Pawn->GetActorLocation());
+	}
+
+	//Greedy nearest-unvisited walk, forking to ChainForkCount targets per hop
+	TBitArray<> Visited(false, Candidates.Num());
+	TArray<TPair<APawn*, FVector>> Frontier = {{HitEnemy, Origin}};
+	TArray<TPair<APawn*, FVector>> NextFrontier;
+	TArray<float, TInlineAllocator<32>> DistSq;
+	DistSq.SetNumUninitialized(Candidates.Num());
+
+	for (int32 Depth = 1; Depth <= NumBounces && !Frontier.IsEmpty(); Depth++)
+	{
+		NextFrontier.Reset();
+
+		for (const TPair<APawn*, FVector>& Source : Frontier)
+		{
+			//Distance to every candidate in one batch
+			Y25::CombatMath::DistanceSquared(CandidateLocations, Source.Value, DistSq);
+
+			for (int32 Fork = 0; Fork < GetChainForkCount(); Fork++)
+			{
+				int32 Nearest = INDEX_NONE;
+				float NearestDistSq = FMath::Square(HopRange);
+
+				for (int32 Index = 0; Index < Candidates.Num(); Index++)
+				{
+					if (!Visited[Index] && DistSq[Index] <= NearestDistSq)
+					{
+						Nearest = Index;
+						NearestDistSq = DistSq[Index];
+					}
+				}
+
+				//Nothing left in range of this source
+				if (Nearest == INDEX_NONE)
+				{
+					break;
+				}
+
+				Visited[Nearest] = true;
+				OutPath.Add({Source.Key, Candidates[Nearest], Depth});
+				NextFrontier.Add({Candidates[Nearest], CandidateLocations.Get(Nearest)});
+			}
+		}
+		Swap(Frontier, NextFrontier);
+	}
 }
 
 ABaseEnemy* AGun::FindNearestPawn(
@@ -1181,51 +2366,18 @@ ABaseEnemy* AGun::FindNearestPawn(
 	const FVector& HitLocation,
 	const TSet<APawn*> PreviousTargets) const
 {
-	//Ignore all previous targets
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this);
-	for (APawn* PreviousTarget : PreviousTargets)
+	const UTargetIndexSubsystem* TargetIndex = GetWorld()->GetSubsystem<UTargetIndexSubsystem>();
+	if (!TargetIndex)
 	{
-		CollisionParams.AddIgnoredActor(PreviousTarget);
+		return nullptr;
 	}
 
-	FCollisionResponseParams ResponseParams;
-	ResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Block);
-
-	//Sphere trace
-	TArray<FHitResult> HitResults;
-	const bool bFoundTarget = GetWorld()->SweepMultiByChannel(
-		HitResults,
-		HitLocation,
-		HitLocation,
-		FQuat::Identity,
-		Y25::Collision::Channels::Weapon,
-		FCollisionShape::MakeSphere(MaxDistance),
-		CollisionParams,
-		ResponseParams);
-
-	if (!bFoundTarget) {return nullptr;}
-
-	//Get closest pawn
-	HitResults.Sort(
-		[](const FHitResult& A, const FHitResult& B)
-		{
-			return A.Distance < B.Distance;
-		});
+	//Closest living enemy that hasn't been hit yet
+	TArray<APawn*> Nearest;
+	TargetIndex->QueryNearest(HitLocation, MaxDistance, 1, Nearest, ETargetKind::Enemy, &PreviousTargets);
 
 	//return nearest enemy or nothing
-	for (FHitResult HitResult : HitResults)
-	{
-		if (HitResult.GetActor()->IsA(ABaseEnemy::StaticClass()))
-		{
-			if (ABaseEnemy* BaseEnemy = Cast<ABaseEnemy>(HitResult.GetActor()))
-			{
-				if (BaseEnemy->IsDead()) {continue;}
-				return BaseEnemy;
-			}
-		}
-	}
-	return nullptr;
+	return Nearest.IsEmpty() ? nullptr : Cast<ABaseEnemy>(Nearest[0]);
 }
 
 void AGun::LaserLineTraceEffect(FVector& LaunchDirection, const TArray<FHitResult>& Hits)
@@ -1245,8 +2397,9 @@ void AGun::LaserLineTraceEffect(FVector& LaunchDirection, const TArray<FHitResul
 
 		// Create tracer effect
 		TracerData->MuzzlePosition = GetMuzzleTransform();
-		TracerData->AmmoType = GetAmmoType();
-		TracerData->GunMesh = GunMesh;
+		TracerData->AmmoType = EAmmoType::Piercing;
+		TracerData->bShotAudioHandled = IsShotAudioHandled();
+		TracerData->GunMesh = GetGunMesh();
 		if (BlockHit)
 		{
 			TracerData->ImpactPositions = {BlockHit->Location};
@@ -1255,10 +2408,13 @@ void AGun::LaserLineTraceEffect(FVector& LaunchDirection, const TArray<FHitResul
 		{
 			TracerData->ImpactPositions = {GetMuzzleTransform() + LaunchDirection * MyAttributes->GetRange()};
 		}
-		Gameplay::Cue(Y25::Cues::Gun_Tracer)
-			.Instigator(GetInstigator())
-			.SourceObject(TracerData)
-			.Execute(this);
+		if (CanPlayCue(EGunCuePriority::Tracer, TracerData->MuzzlePosition))
+		{
+			Gameplay::Cue(Y25::Cues::Gun_Tracer)
+				.Instigator(GetInstigator())
+				.SourceObject(TracerData)
+				.Execute(this);
+		}
 	}
 
 	//If no hits
@@ -1267,12 +2423,18 @@ void AGun::LaserLineTraceEffect(FVector& LaunchDirection, const TArray<FHitResul
 
 	bool bHitCounted = true;
 
+	//Enemies with several hitboxes overlap once per capsule, only count them once
+	TArray<const AActor*, TInlineAllocator<8>> PiercedActors;
+
 	//For each hit
 	for (const FHitResult& HitResult : Hits)
 	{
 		if (!IsValid(HitResult.GetActor())) {continue;}
 
-		CheckEnemyHit(LaunchDirection, HitResult, Y25::Cues::Gun_AmmoHit_Laser, &bHitCounted);
+		if (PiercedActors.Contains(HitResult.GetActor())) {continue;}
+		PiercedActors.Add(HitResult.GetActor());
+
+		CheckEnemyHit(EAmmoType::Piercing, LaunchDirection, HitResult, Y25::Cues::Gun_AmmoHit_Laser, &bHitCounted);
 
 		//increment and check if done with pierces
 		PierceCounter++;
@@ -1290,8 +2452,9 @@ void AGun::DealDamage(const float DamageToDeal, ABaseEnemy* Target)
 		PowerStationAbility(Target);
 	}
 
-	//Deal damage to enemies
-	AController* InstigatingActor = Cast<AMainCharacter>(GetOwner())->GetController();
+	//Deal damage to enemies, a gun without an owner still deals it uncredited
+	const AMainCharacter* CharacterOwner = Cast<AMainCharacter>(GetOwner());
+	AController* InstigatingActor = CharacterOwner ? CharacterOwner->GetController() : nullptr;
 
 	const TSubclassOf<UDamageType> ValidDamageTypeClass = UDamageType::StaticClass();
 	const FDamageEvent DamageEvent(ValidDamageTypeClass);
@@ -1319,20 +2482,7 @@ void AGun::DealAllyDamage(const float DamageToDeal, FVector& LaunchDirection, AM
 	Target->PlayVO(Y25::Cues::Player_FriendlyFire);
 
 	//Gameplay spec to deal damage through ability system component
-	if (UAbilitySystemComponent* AbilitySystemComponent = Target->GetAbilitySystemComponent())
-	{
-		FGameplayEffectContextHandle EffectContextHandle = AbilitySystemComponent->MakeEffectContext();
-		EffectContextHandle.AddSourceObject(this);
-
-		const FGameplayEffectSpecHandle SpecHandle = AbilitySystemComponent->
-			MakeOutgoingSpec(DamageEffect, 1.f, EffectContextHandle);
-
-		if (SpecHandle.IsValid())
-		{
-			SpecHandle.Data->SetSetByCallerMagnitude(Y25::Tags::GameplayEffect_Health_Damaged, DamageToDeal);
-			AbilitySystemComponent->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
-		}
-	}
+	EffectSpecs.Apply(DamageEffect, Target->GetAbilitySystemComponent(), this, DamageToDeal);
 
 	//Launch allies, less launch in air
 	float LaunchForce = MyAttributes->GetKnockBackForce();
@@ -1347,6 +2497,44 @@ void AGun::DealAllyDamage(const float DamageToDeal, FVector& LaunchDirection, AM
 		false);
 }
 
+void AGun::PrewarmGrenadePool(AController* Player) const
+{
+	if (!Player || GrenadePoolSize <= 0 || bSimulateGrenades)
+	{
+		return;
+	}
+
+	if (UGrenadePoolSubsystem* GrenadePool = GetWorld()->GetSubsystem<UGrenadePoolSubsystem>())
+	{
+		GrenadePool->Prewarm(GrenadeClass, Player, GetOwner(), GrenadePoolSize);
+	}
+}
+
+void AGun::FollowOwnerController()
+{
+	//Grenade pools and tick order follow the owner's controller, which may not be there yet
+	if (APawn* PawnOwner = Cast<APawn>(GetOwner()))
+	{
+		PawnOwner->ReceiveControllerChangedDelegate.AddUniqueDynamic(this, &ThisClass::HandleOwnerControllerChanged);
+		HandleOwnerControllerChanged(PawnOwner, nullptr, PawnOwner->GetController());
+	}
+}
+
+void AGun::HandleOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
+{
+	//Aim assist slowdown reads this frame's look input, so the controller has to have applied it first
+	if (OldController)
+	{
+		RemoveTickPrerequisiteActor(OldController);
+	}
+	if (NewController)
+	{
+		AddTickPrerequisiteActor(NewController);
+	}
+
+	PrewarmGrenadePool(NewController);
+}
+
 void AGun::SpawnGrenade(FVector& SpawnLocation) const
 {
 	const UAttributeSet_Gun* MyAttributes = AbilitySystemComponent->GetSet<UAttributeSet_Gun>();
@@ -1365,6 +2553,43 @@ void AGun::SpawnGrenade(FVector& SpawnLocation) const
 	AMainPlayerController* InstigatingActor = Cast<AMainPlayerController>(
 		Cast<AMainCharacter>(GetOwner())->GetController());
 
+	const float Speed = MyAttributes->GetBulletSpeed();
+
+	//Actorless grenade, stepped with every other grenade in flight
+	if (UGrenadeSimulationSubsystem* GrenadeSimulation = GetWorld()->GetSubsystem<UGrenadeSimulationSubsystem>();
+		GrenadeSimulation && bSimulateGrenades)
+	{
+		GrenadeSimulation->Launch(
+			GrenadeClass,
+			SpawnLocation,
+			GetGrenadeLaunchVelocity(AimVector),
+			Speed,
+			MyAttributes->GetBulletDamage(),
+			MyAttributes->GetKnockBackForce(),
+			InstigatingActor);
+		return;
+	}
+
+	//Reuse a pooled grenade when possible
+	if (UGrenadePoolSubsystem* GrenadePool = GetWorld()->GetSubsystem<UGrenadePoolSubsystem>();
+		GrenadePool && GrenadePoolSize > 0)
+	{
+		if (AGrenadeProjectile* Projectile = GrenadePool->Acquire(
+			GrenadeClass,
+			InstigatingActor,
+			MainCharacter,
+			SpawnTransform))
+		{
+			Projectile->NewInitialize(
+				MyAttributes->GetBulletDamage(),
+				Speed,
+				Speed,
+				InstigatingActor,
+				MyAttributes->GetKnockBackForce());
+			return;
+		}
+	}
+
 	//Delay spawn
 	if (AGrenadeProjectile* Projectile = GetWorld()->SpawnActorDeferred<AGrenadeProjectile>(
 		GrenadeClass,
@@ -1374,7 +2599,6 @@ void AGun::SpawnGrenade(FVector& SpawnLocation) const
 		ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn))
 	{
 		//Initialize the rest of the needed values
-		const float Speed = MyAttributes->GetBulletSpeed();
 		Projectile->NewInitialize(
 			MyAttributes->GetBulletDamage(),
 			Speed,
@@ -1406,15 +2630,56 @@ void AGun::PowerStationAbility(AActor* Target)
 
 	if (UAbilitySystemComponent* Asc = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(CurrentTarget))
 	{
-		const FGameplayEffectContextHandle EffectContext = Asc->MakeEffectContext();
-		const FGameplayEffectSpecHandle SpecHandle = Asc->MakeOutgoingSpec(PowerStationShipEffect, 1.0f, EffectContext);
-		if (SpecHandle.IsValid())
-		{
-			Asc->ApplyGameplayEffectSpecToSelf(*SpecHandle.Data.Get());
-		}
+		ApplyStatusEffect(PowerStationShipEffect, Asc);
 	}
 	else
 	{
 		//UE_LOG(LogGun, Log, TEXT("No ASC in Enemies"));
 	}
 }
+
+float AGun::GetStatusEffectWindow(const TSubclassOf<UGameplayEffect> EffectClass) const
+{
+	//Reapply by half way through a timed effect so steady fire never lets it lapse
+	const UGameplayEffect* Effect = EffectClass->GetDefaultObject<UGameplayEffect>();
+	float Duration = 0;
+	if (Effect->DurationPolicy == EGameplayEffectDurationType::HasDuration &&
+		Effect->DurationMagnitude.GetStaticMagnitudeIfPossible(1, Duration) &&
+		Duration > 0)
+	{
+		return FMath::Min(StatusEffectRefreshInterval, Duration / 2);
+	}
+	return StatusEffectRefreshInterval;
+}
+
+void AGun::ApplyStatusEffect(const TSubclassOf<UGameplayEffect> EffectClass, UAbilitySystemComponent* Target)
+{
+	if (!EffectClass || !Target)
+	{
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	//Already applied recently, the running effect covers this hit
+	double& LastApplied = StatusEffectTimes.FindOrAdd({Target, EffectClass}, -StatusEffectRefreshInterval);
+	if (Now - LastApplied < GetStatusEffectWindow(EffectClass))
+	{
+		return;
+	}
+
+	LastApplied = Now;
+	EffectSpecs.Apply(EffectClass, Target, this);
+
+	//Forget targets that haven't been hit in a while
+	if (StatusEffectTimes.Num() > 256)
+	{
+		for (auto It = StatusEffectTimes.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value() >= StatusEffectRefreshInterval)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
@@ -3,19 +3,27 @@
 #pragma once
 
 #include "AbilitySystemInterface.h"
+#include "Camera/CameraTypes.h"
 #include "Delegates/DelegateCombinations.h"
 #include "GameFramework/Actor.h"
 #include "GameplayEffect.h"
 #include "Utils/Gameplay/Cue.h"
+#include "Y25/Combat/EffectSpecCache.h"
 #include "Y25/Enemies/BaseEnemy.h"
 #include "Y25/Weapons/GrenadeProjectile.h"
+#include "Y25/Weapons/GunAudioSubsystem.h"
 #include "Y25/Game/Control/ControlHUD.h"
 
 #include "Gun.generated.h"
 
+class AController;
 class AMainCharacter;
 class UShopData_Item;
 class UGunTracerData;
+class UGrenadeTrajectoryComponent;
+struct FStreamableHandle;
+struct FWeaponShotRequest;
+enum class EGunCuePriority : uint8;
 class AGunVisualEffects;
 class UAttributeSet_Gun;
 
@@ -66,6 +74,22 @@ DECLARE_MULTICAST_DELEGATE_OneParam(FOnReticleSwapAnim, EGunType gunType);
 
 DECLARE_MULTICAST_DELEGATE(FOnShootAnim);
 
+//One hop of a planned chain lightning path
+struct FChainHop
+{
+	TWeakObjectPtr<APawn> Source;
+	TWeakObjectPtr<ABaseEnemy> Target;
+	int32 Depth = 0;
+};
+
+//The starting loadout as BeginPlay set it up, restored in one go when a pooled gun is reused
+struct FGunLoadoutSnapshot
+{
+	EGunType GunType = EGunType::Pistol;
+	EAmmoType AmmoType = EAmmoType::Bullet;
+	TArray<TPair<FGameplayAttribute, float>> AttributeBases;
+};
+
 UCLASS(Abstract, Config=Game)
 class Y25_API AGun : public AActor, public IAbilitySystemInterface
 {
@@ -85,6 +109,7 @@ public:
 
 	FOnGunChange OnGunChange;
 
+	//Listeners playing sounds from the shoot anim should skip them when IsShotAudioHandled
 	FOnShootAnim OnShootAnim;
 
 	FOnReticleSwapAnim OnReticleSwapAnim;
@@ -131,24 +156,79 @@ public:
 private:
 #pragma region gunVars
 
-	//Gun Mesh
+	//Gun Mesh. With bPreinstanceMeshes this is only the root and a variant is the one shown, use GetGunMesh for the
+	//visible mesh
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="GunMesh", meta=(AllowPrivateAccess=true))
 	TObjectPtr<USkeletalMeshComponent> GunMesh;
 
+	//Streamed in when equipped or prefetched so unused guns aren't kept loaded
 	UPROPERTY(EditAnywhere, Category="GunMesh")
-	TArray<TObjectPtr<USkeletalMesh>> GunMeshes;
+	TArray<TSoftObjectPtr<USkeletalMesh>> GunMeshes;
 
 	//Magazine Mesh
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="GunMesh", meta=(AllowPrivateAccess=true))
 	TObjectPtr<USkeletalMeshComponent> MagMesh;
 
 	UPROPERTY(EditAnywhere, Category="GunMesh")
-	TArray<TObjectPtr<USkeletalMesh>> MagMeshes;
+	TArray<TSoftObjectPtr<USkeletalMesh>> MagMeshes;
+
+	//Prefetched loadouts kept loaded for likely swaps, the oldest is released past this
+	UPROPERTY(EditAnywhere, Category="GunMesh", meta=(ClampMin=0))
+	int32 MaxPrefetchedLoadouts = 2;
+
+	//Keep the equipped meshes loaded
+	TSharedPtr<FStreamableHandle> GunMeshHandle;
+	TSharedPtr<FStreamableHandle> MagMeshHandle;
+
+	//Equipped gun mesh is still streaming in, CanFire is false until it's set
+	bool bGunMeshLoading = false;
+
+	//Oldest first
+	TArray<TSharedPtr<FStreamableHandle>> PrefetchHandles;
+
+	//Give every mesh its own hidden component up front so swaps only toggle visibility. Trades memory for swap time,
+	//every mesh stays loaded for as long as the gun exists instead of only the equipped and prefetched ones.
+	UPROPERTY(EditAnywhere, Category="GunMesh")
+	bool bPreinstanceMeshes = false;
+
+	//One per GunMeshes and MagMeshes entry, attached to the gun. Only the shown one collides, like its template would
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USkeletalMeshComponent>> GunMeshVariants;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<USkeletalMeshComponent>> MagMeshVariants;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> ActiveGunMesh;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USkeletalMeshComponent> ActiveMagMesh;
+
+	TSharedPtr<FStreamableHandle> MeshVariantsHandle;
+
+	//Stop the mesh components ticking while nothing plays on them, shots, reloads and swaps wake them back up
+	UPROPERTY(EditAnywhere, Category="GunMesh")
+	bool bSleepIdleMeshes = false;
+
+	//Time after waking before the meshes can sleep again, gives the shot and reload animations time to start
+	UPROPERTY(EditAnywhere, Category="GunMesh", meta=(ClampMin=0, EditCondition="bSleepIdleMeshes"))
+	float MeshWakeTime = 0.25f;
+
+	bool bMeshesAwake = true;
+
+	double MeshWakeStartTime = 0;
+
+	//Grenade arc shown while grenade ammo is loaded
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Grenade", meta=(AllowPrivateAccess=true))
+	TObjectPtr<UGrenadeTrajectoryComponent> GrenadePreview;
 
 	//effects
 
 	FActiveGameplayEffectHandle AmmoGameplayEffect;
 
+	//Outgoing specs reused by friendly fire and status effects
+	FEffectSpecCache EffectSpecs;
+
 	FActiveGameplayEffectHandle PureModPlayEffect;
 
 	FActiveGameplayEffectHandle GunGameplayEffect;
@@ -167,6 +247,10 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gun", meta = (AllowPrivateAccess = true))
 	float ChainBounceRange = 1000;
 
+	//How many new targets each chain hop can fork to
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gun", meta = (AllowPrivateAccess = true, ClampMin = 1))
+	int32 ChainForkCount = 1;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gun", meta = (AllowPrivateAccess = true))
 	float CritDamageMultiplier = 1.5;
 
@@ -199,6 +283,34 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Gun", meta = (AllowPrivateAccess = true))
 	int32 CapRadius = 25;
 
+	//Only applies while the player's last input came from a gamepad
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Aim Assist", meta = (AllowPrivateAccess = true))
+	bool bAimAssistEnabled = true;
+
+	//Half angle in degrees of the view cone searched for targets
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Aim Assist", meta = (AllowPrivateAccess = true, ClampMin = 0, ClampMax = 45))
+	float AimAssistConeAngle = 8.0f;
+
+	//Degrees per second the aim is pulled towards the target while aiming
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Aim Assist", meta = (AllowPrivateAccess = true, ClampMin = 0))
+	float AimAssistMagnetism = 6.0f;
+
+	//Look speed scale while the aim ray is within CapRadius of the target
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Aim Assist", meta = (AllowPrivateAccess = true, ClampMin = 0, ClampMax = 1))
+	float AimAssistSlowdown = 0.5f;
+
+	UPROPERTY(Transient)
+	TObjectPtr<APawn> AimAssistTarget;
+
+	//Reused every frame so the cone query doesn't allocate
+	TArray<APawn*> AimAssistCandidates;
+
+	//Slowdown applied to next frame's look input, 1 when not on a target
+	float AimAssistLookScale = 1.0f;
+
+	//Control rotation once the gun was done with it last frame, unset while assist is off
+	TOptional<FRotator> AimAssistLastRotation;
+
 	// Tracer/Ammo trail
 	UPROPERTY(Transient)
 	TObjectPtr<UGunTracerData> TracerData;
@@ -255,6 +367,12 @@ public:
 	//Apply the Gameplay Effect
 	virtual void PowerStationAbility(AActor* Target);
 
+	//Apply a ship status effect, at most once per GetStatusEffectWindow for each target
+	void ApplyStatusEffect(TSubclassOf<UGameplayEffect> EffectClass, UAbilitySystemComponent* Target);
+
+	//StatusEffectRefreshInterval, or less for an effect short enough to run out before then
+	float GetStatusEffectWindow(TSubclassOf<UGameplayEffect> EffectClass) const;
+
 	//Called when the PowerStationShip dies
 	UFUNCTION()
 	virtual void HandleOnPowerStationDeath();
@@ -264,6 +382,24 @@ public:
 	UFUNCTION(BlueprintCallable)
 	FVector GetMuzzleTransform() const;
 
+	const FGunShotAudio& GetShotAudio() const;
+
+	//Shot sounds come from the gun audio subsystem, so fire cues and the shoot anim should stay silent
+	UFUNCTION(BlueprintPure, Category = "Y25|Gun")
+	bool IsShotAudioHandled() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
+	APawn* GetAimAssistTarget() const;
+
+	//Visible enemy inside the view cone closest to the aim ray, Candidates is scratch space
+	static APawn* FindAimAssistTarget(
+		const UWorld* World,
+		const FMinimalViewInfo& ViewInfo,
+		float ConeAngleDegrees,
+		float Range,
+		const FCollisionQueryParams& QueryParams,
+		TArray<APawn*>& Candidates);
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="AimOffset")
 	float XOffset = 0;
 
@@ -278,6 +414,14 @@ public:
 
 	void ChangeMagMesh(int8 Index);
 
+	//Start streaming the meshes for a likely swap, like a shop offer or a picked up mod
+	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
+	void PrefetchLoadout(EGunType NextGunType, EAmmoType NextAmmoType);
+
+	static int8 GetGunMeshIndex(EGunType Type);
+
+	static int8 GetMagMeshIndex(EAmmoType Ammo);
+
 	//Gun Functions
 
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
@@ -289,15 +433,20 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void ShootGun();
 
+	//Where the view trace lands, scattered by the spread angle unless bApplySpread is off
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
-	FVector GetSpreadPoint() const;
+	FVector GetSpreadPoint(bool bApplySpread = true) const;
 
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void LineTrace(const FVector& TraceStart);
 
+	//Resolves the hit as the ammo loaded right now, see ResolveBulletChainHit for shots fired earlier
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void BulletChainLineTraceEffect(FVector& LaunchDirection, const FHitResult& Hit);
 
+	//Ballistic round from this gun landed, or gave out at Hit.TraceEnd without a blocking hit
+	void OnBallisticRoundHit(EAmmoType AmmoType, const FVector& Origin, FVector Direction, const FHitResult& Hit);
+
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void DealDamage(float DamageToDeal, ABaseEnemy* Target);
 
@@ -307,8 +456,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void ChainBounce(APawn* HitEnemy, FVector& LaunchDirection);
 
+	//Plan and run a chain from HitEnemy with RemainingBounces hops, never bouncing to CollidedTargets
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
-	void ChainBounceHelper(TSet<APawn*> CollidedTargets, APawn* HitEnemy, float RemainingBounces, FVector LaunchDirection);
+	void ChainBounceHelper(
+		TSet<APawn*> CollidedTargets,
+		APawn* HitEnemy,
+		float RemainingBounces,
+		FVector LaunchDirection);
+
+	void ChainBounceHops(const TArray<FChainHop>& ChainPath, int32 Depth, int32 NumBounces);
+
+	void PlanChainPath(
+		APawn* HitEnemy,
+		int32 NumBounces,
+		TArray<FChainHop>& OutPath,
+		const TSet<APawn*>& ExcludedTargets = {}) const;
 
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	ABaseEnemy* FindNearestPawn(const float MaxDistance, const FVector& HitLocation, const TSet<APawn*> PreviousTargets) const;
@@ -319,6 +481,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void SpawnGrenade(FVector& SpawnLocation) const;
 
+	//Fill this player's grenade pool, does nothing until the owner is possessed
+	void PrewarmGrenadePool(AController* Player) const;
+
+	void FollowOwnerController();
+
+	//Owner was possessed or unpossessed, the gun ticks after its controller
+	UFUNCTION()
+	void HandleOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
 	UFUNCTION(BlueprintCallable, Category = "Y25|Gun")
 	void AddAmmoToReserve(const int32 AmountToAdd);
 
@@ -336,11 +507,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category="GetSet")
 	EAmmoType GetAmmoType() const;
 
+	//The shown variant when meshes are preinstanced
 	UFUNCTION()
-	USkeletalMeshComponent* GetGunMesh();
+	USkeletalMeshComponent* GetGunMesh() const;
 
 	UFUNCTION()
-	USkeletalMeshComponent* GetMagMesh();
+	USkeletalMeshComponent* GetMagMesh() const;
 
 	UFUNCTION(Category="GetSet")
 	void SetReloadTime(float NewTime);
@@ -399,6 +571,9 @@ public:
 	UFUNCTION(Category="GetSet")
 	float GetChainBounceRange() const;
 
+	UFUNCTION(Category="GetSet")
+	int32 GetChainForkCount() const;
+
 	UFUNCTION(Category="GetSet")
 	float GetCritDamageMultiplier() const;
 
@@ -410,6 +585,27 @@ public:
 #pragma endregion
 
 protected:
+	friend class UGunPoolSubsystem;
+	friend class UWeaponTraceSubsystem;
+
+	//Pool hooks, hand the gun to a new life or park it while its player is dead
+	void ActivateFromPool(AActor* NewOwner);
+
+	void DeactivateToPool();
+
+	//Player whose pool this gun returns to, unset when spawned outside a pool
+	TWeakObjectPtr<AController> PoolPlayer;
+
+	//Bumped every time the gun is parked, timer lambdas from an earlier life check it and do nothing
+	uint32 PoolGeneration = 0;
+
+	FGunLoadoutSnapshot LoadoutSnapshot;
+
+	void CaptureLoadoutSnapshot();
+
+	//Back to the starting loadout without reapplying its effects
+	void ResetToLoadoutSnapshot();
+
 	//Check if Effect should apply
 	bool IsPowerStationShipAlive = false;
 
@@ -417,15 +613,77 @@ protected:
 	
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void PostInitializeComponents() override;
 
+	//Point the gun at the player's ability system and add its attributes there
+	void HostOnPlayerAbilitySystem();
+
+	//Swap the client's stand-in attributes for the server's once they replicate
+	void ResolveReplicatedAttributeSet();
+
 	int32& GetStat(FName Name) const;
 
 	float& GetTrueStat(FName Name) const;
 
 	void UpdateAccuracy() const;
 
+	FMinimalViewInfo GetOwnerViewInfo() const;
+
+	void CreateMeshVariants();
+
+	void WakeMeshes();
+
+	//Sleep the meshes once neither has an animation or montage playing
+	void UpdateMeshSleep();
+
+	//Show Next in place of Active, carrying over whatever it was playing and Template's collision
+	static void SwapMeshVariant(
+		TObjectPtr<USkeletalMeshComponent>& Active,
+		USkeletalMeshComponent* Next,
+		const USkeletalMeshComponent* Template);
+
+	//Whether the frame's gun cue budget has room for a cue at Location
+	bool CanPlayCue(EGunCuePriority Priority, const FVector& Location) const;
+
+	//Every cue this gun can fire with the ammo types it has
+	FGameplayTagContainer GetCueTags() const;
+
+	void UpdateAimAssist(float DeltaTime);
+
+	//Scale down the look input since last frame while on an aim assist target
+	void ApplyAimAssistSlowdown();
+
+	//Velocity SpawnGrenade launches with when aiming at AimPoint
+	FVector GetGrenadeLaunchVelocity(const FVector& AimPoint) const;
+
+	void UpdateGrenadePreview();
+
+	//Gun facing from the aim trace, traced here or by the batch
+	void ApplyAimTrace(const FHitResult& HitResult);
+
+	//Pellets of one shot for the trace batch
+	FWeaponShotRequest MakeShotRequest(const FVector& TraceStart, int32 NumPellets) const;
+
+	//One pellet's result from the trace batch, handled as the ammo it was fired with
+	void ApplyShotTrace(
+		EAmmoType AmmoType,
+		FVector Direction,
+		const FHitResult& Hit,
+		const TArray<FHitResult>& PierceHits);
+
+	//Tracer, cue and damage for a bullet or chain shot from Muzzle, as the ammo it was fired with
+	void ResolveBulletChainHit(
+		EAmmoType AmmoType,
+		const FVector& Muzzle,
+		FVector& LaunchDirection,
+		const FHitResult& Hit);
+
+	void PlayBulletTracer(EAmmoType AmmoType, const FVector& Muzzle, const FVector& Impact);
+
 	void CheckEnemyHit(
+		EAmmoType AmmoType,
 		FVector& LaunchDirection,
 		FHitResult HitResult,
 		FGameplayTag EffectTag,
@@ -435,10 +693,30 @@ protected:
 	UPROPERTY()
 	TObjectPtr<UAttributeSet_Gun> AttributeSet_Gun;
 
+	//Client's own set on the player's ability system until the server's replicates
+	UPROPERTY(Transient)
+	TObjectPtr<UAttributeSet_Gun> LocalAttributeSet;
+
+	FTimerHandle ReplicatedSetTimerHandle;
+
 	UPROPERTY(Transient)
 	//UAbilitySystemComponent* AbilitySystemComponent;
 	TObjectPtr<UAbilitySystemComponent> AbilitySystemComponent;
 
+	//Shot, sustain and hit confirm sounds played through the gun audio subsystem, no shot sound leaves audio to the
+	//fire cues. With a shot sound set, the tracer cue sees bShotAudioHandled and anims see IsShotAudioHandled, and
+	//both are expected to drop their own shot sounds so they don't stack on the subsystem's.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Audio")
+	FGunShotAudio ShotAudio;
+
+	//Aim and shot traces go through the world's trace batch instead of running here
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Weapon")
+	bool bBatchTraces = false;
+
+	//Keep the gun attributes on the owning player's ability system instead of one per gun
+	UPROPERTY(Config)
+	bool bUsePlayerAbilitySystem = false;
+
 	//Slow Down Enemy Effect
 	UPROPERTY(EditAnywhere, Category="ShipEffect")
 	TSubclassOf<UGameplayEffect> PowerStationShipEffect;
@@ -447,7 +725,33 @@ protected:
 	UPROPERTY(EditAnywhere, Category="ShipEffect")
 	TSubclassOf<UGameplayEffect> ArmoryShipEffect;
 
+	//Hits inside this window don't reapply a ship effect to the same target, shortened for timed effects that
+	//would expire first
+	UPROPERTY(EditAnywhere, Category="ShipEffect", meta=(ClampMin=0))
+	float StatusEffectRefreshInterval = 0.5f;
+
+	//When each ship effect last went on each target
+	TMap<TPair<TObjectKey<UAbilitySystemComponent>, TSubclassOf<UGameplayEffect>>, double> StatusEffectTimes;
+
 	//Projectile Type To Fire
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Grenade")
 	TSubclassOf<AGrenadeProjectile> GrenadeClass;
+
+	//Grenades spawned per player at start so firing reuses them, 0 disables pooling
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Grenade", meta = (ClampMin = 0))
+	int32 GrenadePoolSize = 16;
+
+	//Fire grenades into the batched simulation instead of spawning actors
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Grenade")
+	bool bSimulateGrenades = false;
+
+	//Bullet and chain rounds travel with drop instead of hitting instantly
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Ballistics")
+	bool bBallisticRounds = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Ballistics", meta=(ClampMin=1, EditCondition="bBallisticRounds"))
+	float BallisticSpeed = 40000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Ballistics", meta=(ClampMin=0, EditCondition="bBallisticRounds"))
+	float BallisticGravityScale = 1;
 };
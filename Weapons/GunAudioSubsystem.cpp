@@ -0,0 +1,222 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GunAudioSubsystem.h"
+
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundBase.h"
+#include "Y25/Weapons/Gun.h"
+
+DECLARE_STATS_GROUP(TEXT("Y25 Gun Audio"), STATGROUP_Y25GunAudio, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Shots Coalesced"), STAT_GunShotsCoalesced, STATGROUP_Y25GunAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Hit Confirms Coalesced"), STAT_GunHitConfirmsCoalesced, STATGROUP_Y25GunAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Voices Stolen"), STAT_GunVoicesStolen, STATGROUP_Y25GunAudio);
+
+bool UGunAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGunAudioSubsystem::Deinitialize()
+{
+	for (TPair<TObjectKey<AGun>, FGunAudioState>& GunState : States)
+	{
+		if (UAudioComponent* Sustain = GunState.Value.Sustain.Get())
+		{
+			Sustain->Stop();
+		}
+	}
+	States.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UGunAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGunAudioSubsystem, STATGROUP_Tickables);
+}
+
+bool UGunAudioSubsystem::IsSustaining(const AGun* Gun) const
+{
+	const FGunAudioState* State = States.Find(Gun);
+	return State && State->bSustaining;
+}
+
+int32 UGunAudioSubsystem::GetNumVoices(const AGun* Gun) const
+{
+	const FGunAudioState* State = States.Find(Gun);
+	return State ? State->Voices.Num() : 0;
+}
+
+void UGunAudioSubsystem::Shot(AGun* Gun)
+{
+	const FGunShotAudio& Audio = Gun->GetShotAudio();
+	FGunAudioState& State = States.FindOrAdd(Gun);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (State.LastShotTime >= 0)
+	{
+		State.ShotInterval = Now - State.LastShotTime;
+		const bool bFast = Audio.SustainShotsPerSecond > 0 && State.ShotInterval * Audio.SustainShotsPerSecond <= 1;
+		State.FastShots = bFast ? State.FastShots + 1 : 0;
+	}
+	State.LastShotTime = Now;
+
+	//The loop is already covering this shot
+	if (State.bSustaining)
+	{
+		INC_DWORD_STAT(STAT_GunShotsCoalesced);
+		return;
+	}
+
+	if (Audio.SustainSound && State.FastShots >= SustainAfterShots)
+	{
+		StartSustain(Gun, State);
+		return;
+	}
+
+	PlayVoice(Gun, State, Audio.ShotSound);
+}
+
+void UGunAudioSubsystem::HitConfirm(AGun* Gun)
+{
+	if (!Gun->GetShotAudio().HitConfirmSound)
+	{
+		return;
+	}
+
+	FGunAudioState& State = States.FindOrAdd(Gun);
+	if (State.PendingHitConfirms > 0)
+	{
+		INC_DWORD_STAT(STAT_GunHitConfirmsCoalesced);
+	}
+	State.PendingHitConfirms++;
+}
+
+void UGunAudioSubsystem::Tick(const float DeltaTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UGunAudioSubsystem::Tick);
+
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (auto It = States.CreateIterator(); It; ++It)
+	{
+		AGun* Gun = It->Key.ResolveObjectPtr();
+		FGunAudioState& State = It->Value;
+		if (!Gun)
+		{
+			if (UAudioComponent* Sustain = State.Sustain.Get())
+			{
+				Sustain->Stop();
+			}
+			It.RemoveCurrent();
+			continue;
+		}
+
+		//Stopped firing, end the loop with its tail
+		if (State.bSustaining && Now - State.LastShotTime > State.ShotInterval * SustainReleaseIntervals)
+		{
+			StopSustain(Gun, State);
+		}
+
+		//Every hit this frame shares one confirm, a little louder for each extra hit
+		if (State.PendingHitConfirms > 0)
+		{
+			const float Volume = FMath::Min(
+				1 + HitConfirmVolumePerHit * (State.PendingHitConfirms - 1),
+				MaxHitConfirmVolume);
+			PlayVoice(Gun, State, Gun->GetShotAudio().HitConfirmSound, Volume);
+			State.PendingHitConfirms = 0;
+		}
+	}
+}
+
+void UGunAudioSubsystem::StartSustain(AGun* Gun, FGunAudioState& State)
+{
+	const FGunShotAudio& Audio = Gun->GetShotAudio();
+	State.bSustaining = true;
+
+	//The shot sound is the start tail
+	PlayVoice(Gun, State, Audio.ShotSound);
+
+	//Reuse the loop's component between bursts, there is none on the null audio device
+	if (UAudioComponent* Sustain = State.Sustain.Get())
+	{
+		Sustain->Play();
+	}
+	else
+	{
+		State.Sustain = UGameplayStatics::SpawnSoundAttached(
+			Audio.SustainSound,
+			Gun->GetGunMesh(),
+			NAME_None,
+			FVector::ZeroVector,
+			EAttachLocation::KeepRelativeOffset,
+			true,
+			1,
+			1,
+			0,
+			nullptr,
+			nullptr,
+			false);
+	}
+}
+
+void UGunAudioSubsystem::StopSustain(AGun* Gun, FGunAudioState& State)
+{
+	State.bSustaining = false;
+	State.FastShots = 0;
+
+	if (UAudioComponent* Sustain = State.Sustain.Get())
+	{
+		Sustain->FadeOut(SustainFadeOutTime, 0);
+	}
+
+	PlayVoice(Gun, State, Gun->GetShotAudio().SustainTailSound);
+}
+
+void UGunAudioSubsystem::PruneVoices(FGunAudioState& State) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	State.Voices.RemoveAll([Now](const FGunVoice& Voice)
+	{
+		//Voices without a component only have their duration to go on
+		return Voice.EndTime <= Now ||
+			(!Voice.Component.IsExplicitlyNull() && (!Voice.Component.IsValid() || !Voice.Component->IsPlaying()));
+	});
+}
+
+void UGunAudioSubsystem::PlayVoice(AGun* Gun, FGunAudioState& State, USoundBase* Sound, const float VolumeMultiplier)
+{
+	if (!Sound)
+	{
+		return;
+	}
+
+	PruneVoices(State);
+
+	//The sustain always keeps its voice
+	const int32 Budget = FMath::Max(MaxVoicesPerGun - (State.bSustaining ? 1 : 0), 1);
+	while (State.Voices.Num() >= Budget)
+	{
+		if (UAudioComponent* Oldest = State.Voices[0].Component.Get())
+		{
+			Oldest->Stop();
+		}
+		State.Voices.RemoveAt(0);
+		INC_DWORD_STAT(STAT_GunVoicesStolen);
+	}
+
+	UAudioComponent* Voice = UGameplayStatics::SpawnSoundAttached(
+		Sound,
+		Gun->GetGunMesh(),
+		NAME_None,
+		FVector::ZeroVector,
+		EAttachLocation::KeepRelativeOffset,
+		true,
+		VolumeMultiplier);
+
+	State.Voices.Add({Voice, GetWorld()->GetTimeSeconds() + Sound->GetDuration()});
+}
@@ -0,0 +1,125 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "GunAudioSubsystem.generated.h"
+
+class AGun;
+class UAudioComponent;
+class USoundBase;
+
+USTRUCT(BlueprintType)
+struct FGunShotAudio
+{
+	GENERATED_BODY()
+
+	//Played per shot, and as the start of the sustain
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TObjectPtr<USoundBase> ShotSound;
+
+	//Looping sound that replaces per shot sounds during rapid fire
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TObjectPtr<USoundBase> SustainSound;
+
+	//Played when rapid fire stops
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TObjectPtr<USoundBase> SustainTailSound;
+
+	//Played at most once per frame no matter how many enemies were hit
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TObjectPtr<USoundBase> HitConfirmSound;
+
+	//Firing at least this fast switches to the sustain
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(ClampMin=0))
+	float SustainShotsPerSecond = 8;
+};
+
+//Weapon audio for every gun. Rapid fire turns into a looped sustain with start and stop tails, hit confirms are
+//coalesced per frame, and each gun's one shot voices are capped. Voices are tracked by sound duration rather than by
+//the audio components, so it behaves the same on the null audio device. A gun with a shot sound is owned by the
+//subsystem, see AGun::IsShotAudioHandled.
+UCLASS(Config=Game)
+class Y25_API UGunAudioSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	//Gun fired a shot
+	void Shot(AGun* Gun);
+
+	//Gun's shot hit an enemy, played on the next tick with any other hits this frame
+	void HitConfirm(AGun* Gun);
+
+	bool IsSustaining(const AGun* Gun) const;
+
+	//One shot voices the gun has playing, not counting the sustain
+	int32 GetNumVoices(const AGun* Gun) const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	struct FGunVoice
+	{
+		TWeakObjectPtr<UAudioComponent> Component;
+		double EndTime;
+	};
+
+	struct FGunAudioState
+	{
+		double LastShotTime = -1;
+		double ShotInterval = 0;
+
+		//Shots in a row fired faster than the gun's sustain rate
+		int32 FastShots = 0;
+
+		bool bSustaining = false;
+
+		int32 PendingHitConfirms = 0;
+
+		TWeakObjectPtr<UAudioComponent> Sustain;
+
+		TArray<FGunVoice, TInlineAllocator<8>> Voices;
+	};
+
+	//One shot voices each gun can have at once, the oldest is stopped to make room
+	UPROPERTY(Config)
+	int32 MaxVoicesPerGun = 6;
+
+	//Fast shots in a row before the sustain starts
+	UPROPERTY(Config)
+	int32 SustainAfterShots = 3;
+
+	//Shot intervals without a shot before the sustain stops
+	UPROPERTY(Config)
+	float SustainReleaseIntervals = 2;
+
+	UPROPERTY(Config)
+	float SustainFadeOutTime = 0.05f;
+
+	//Extra hit confirm volume for each hit past the first in a frame
+	UPROPERTY(Config)
+	float HitConfirmVolumePerHit = 0.1f;
+
+	UPROPERTY(Config)
+	float MaxHitConfirmVolume = 1.5f;
+
+	void StartSustain(AGun* Gun, FGunAudioState& State);
+
+	void StopSustain(AGun* Gun, FGunAudioState& State);
+
+	void PlayVoice(AGun* Gun, FGunAudioState& State, USoundBase* Sound, float VolumeMultiplier = 1);
+
+	void PruneVoices(FGunAudioState& State) const;
+
+	TMap<TObjectKey<AGun>, FGunAudioState> States;
+};
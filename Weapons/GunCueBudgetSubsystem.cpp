@@ -0,0 +1,130 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GunCueBudgetSubsystem.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_STATS_GROUP(TEXT("Y25 Gun Cues"), STATGROUP_Y25GunCues, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Cues Played"), STAT_GunCuesPlayed, STATGROUP_Y25GunCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Cues Over Budget"), STAT_GunCuesOverBudget, STATGROUP_Y25GunCues);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gun Cues Culled"), STAT_GunCuesCulled, STATGROUP_Y25GunCues);
+
+bool UGunCueBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGunCueBudgetSubsystem::BeginFrame()
+{
+	if (Frame == GFrameCounter)
+	{
+		return;
+	}
+
+	Frame = GFrameCounter;
+	PlayedThisFrame = 0;
+	DroppedThisFrame = 0;
+
+	//Split screen has a camera per local player
+	Views.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (!PlayerController || !PlayerController->IsLocalController() || !PlayerController->PlayerCameraManager)
+		{
+			continue;
+		}
+
+		const APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+		const float HalfFOV = FMath::Min(CameraManager->GetFOVAngle() * 0.5f + ViewMarginDegrees, 180.f);
+
+		Views.Add({
+			CameraManager->GetCameraLocation(),
+			CameraManager->GetCameraRotation().Vector(),
+			FMath::Cos(FMath::DegreesToRadians(HalfFOV))});
+	}
+}
+
+bool UGunCueBudgetSubsystem::IsVisible(const FVector& Location) const
+{
+	//No cameras to judge by, e.g. a dedicated server
+	if (Views.IsEmpty())
+	{
+		return true;
+	}
+
+	const float MaxDistanceSq = FMath::Square(MaxCueDistance);
+	for (const FCueView& View : Views)
+	{
+		const FVector ToCue = Location - View.Location;
+		const float DistanceSq = ToCue.SizeSquared();
+		if (DistanceSq > MaxDistanceSq)
+		{
+			continue;
+		}
+
+		//Right at the camera, or inside its view
+		if (DistanceSq < KINDA_SMALL_NUMBER || (ToCue.GetUnsafeNormal() | View.Direction) >= View.CosHalfFOV)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+float UGunCueBudgetSubsystem::GetBudgetShare(const EGunCuePriority Priority) const
+{
+	switch (Priority)
+	{
+	case EGunCuePriority::Miss:
+		return MissBudgetShare;
+	case EGunCuePriority::Tracer:
+		return TracerBudgetShare;
+	case EGunCuePriority::Hit:
+		return HitBudgetShare;
+	case EGunCuePriority::Crit:
+	case EGunCuePriority::Kill:
+	default:
+		return 1;
+	}
+}
+
+bool UGunCueBudgetSubsystem::TryPlay(const EGunCuePriority Priority, const FVector& Location)
+{
+	BeginFrame();
+
+	//Kills always show if someone could see them, everything else also has to fit
+	bool bPlay = IsVisible(Location);
+	if (!bPlay)
+	{
+		INC_DWORD_STAT(STAT_GunCuesCulled);
+	}
+	else if (Priority != EGunCuePriority::Kill && PlayedThisFrame >= MaxCuesPerFrame * GetBudgetShare(Priority))
+	{
+		INC_DWORD_STAT(STAT_GunCuesOverBudget);
+		bPlay = false;
+	}
+
+	if (!bPlay)
+	{
+		DroppedThisFrame++;
+		DroppedTotals[static_cast<int32>(Priority)]++;
+		return false;
+	}
+
+	PlayedThisFrame++;
+	INC_DWORD_STAT(STAT_GunCuesPlayed);
+	return true;
+}
+
+int32 UGunCueBudgetSubsystem::GetDroppedThisFrame() const
+{
+	return Frame == GFrameCounter ? DroppedThisFrame : 0;
+}
+
+int32 UGunCueBudgetSubsystem::GetDroppedTotal(const EGunCuePriority Priority) const
+{
+	return DroppedTotals[static_cast<int32>(Priority)];
+}
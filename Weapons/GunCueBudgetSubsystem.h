@@ -0,0 +1,83 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GunCueBudgetSubsystem.generated.h"
+
+//How much a gun cue matters when the frame's budget runs low
+enum class EGunCuePriority : uint8
+{
+	Miss,
+	Tracer,
+	Hit,
+	Crit,
+	Kill,
+	Count,
+};
+
+//Caps how many gun cues play each frame. Cues nobody can see are culled, and low priority cues stop once their
+//share of the frame's budget is used so crits and kills always have room.
+UCLASS(Config=Game)
+class Y25_API UGunCueBudgetSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//Whether a cue of Priority at Location should play, counts it against the frame's budget if so
+	bool TryPlay(EGunCuePriority Priority, const FVector& Location);
+
+	int32 GetDroppedThisFrame() const;
+
+	int32 GetDroppedTotal(EGunCuePriority Priority) const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	struct FCueView
+	{
+		FVector Location;
+		FVector Direction;
+		float CosHalfFOV;
+	};
+
+	UPROPERTY(Config)
+	int32 MaxCuesPerFrame = 48;
+
+	//Share of the frame's budget each priority can use, kills and crits can always use all of it
+	UPROPERTY(Config)
+	float MissBudgetShare = 0.25f;
+
+	UPROPERTY(Config)
+	float TracerBudgetShare = 0.5f;
+
+	UPROPERTY(Config)
+	float HitBudgetShare = 0.75f;
+
+	//Cues farther than this from every local player's camera are culled
+	UPROPERTY(Config)
+	float MaxCueDistance = 8000;
+
+	//Extra degrees around each camera's view that still count as on screen
+	UPROPERTY(Config)
+	float ViewMarginDegrees = 10;
+
+	void BeginFrame();
+
+	bool IsVisible(const FVector& Location) const;
+
+	float GetBudgetShare(EGunCuePriority Priority) const;
+
+	uint64 Frame = MAX_uint64;
+
+	int32 PlayedThisFrame = 0;
+
+	int32 DroppedThisFrame = 0;
+
+	TStaticArray<int32, static_cast<int32>(EGunCuePriority::Count)> DroppedTotals{InPlace, 0};
+
+	//Every local player's camera this frame
+	TArray<FCueView, TInlineAllocator<4>> Views;
+};
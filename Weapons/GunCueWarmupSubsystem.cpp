@@ -0,0 +1,171 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GunCueWarmupSubsystem.h"
+
+#include "AbilitySystemGlobals.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameplayCueManager.h"
+#include "GameplayCueNotify_Actor.h"
+#include "GameplayCueSet.h"
+
+DECLARE_LOG_CATEGORY_CLASS(LogGunCueWarmup, Log, All);
+
+bool UGunCueWarmupSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGunCueWarmupSubsystem::Deinitialize()
+{
+	if (!WarmedTags.IsEmpty())
+	{
+		if (const int32 LateLoads = CountLateLoads())
+		{
+			UE_LOG(LogGunCueWarmup, Warning, TEXT("%d gun cues loaded after warmup"), LateLoads);
+		}
+		else
+		{
+			UE_LOG(LogGunCueWarmup, Log, TEXT("No gun cues loaded after warmup"));
+		}
+	}
+
+	for (const TSharedPtr<FStreamableHandle>& Handle : LoadHandles)
+	{
+		if (Handle.IsValid())
+		{
+			Handle->ReleaseHandle();
+		}
+	}
+	LoadHandles.Empty();
+
+	Super::Deinitialize();
+}
+
+UGameplayCueSet* UGunCueWarmupSubsystem::GetRuntimeCueSet()
+{
+	const UGameplayCueManager* CueManager = UAbilitySystemGlobals::Get().GetGameplayCueManager();
+	return CueManager ? CueManager->GetRuntimeCueSet() : nullptr;
+}
+
+void UGunCueWarmupSubsystem::Warmup(const FGameplayTagContainer& CueTags)
+{
+	//Servers don't play cues
+	UGameplayCueSet* CueSet = GetRuntimeCueSet();
+	if (!CueSet || IsRunningDedicatedServer())
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Cues the engine already loaded aren't late, only note them on the first warmup so mid round loads still count
+	if (WarmedTags.IsEmpty())
+	{
+		for (int32 DataIndex = 0; DataIndex < CueSet->GameplayCueData.Num(); DataIndex++)
+		{
+			if (CueSet->GameplayCueData[DataIndex].LoadedGameplayCueClass)
+			{
+				ResidentCues.Add(DataIndex);
+			}
+		}
+	}
+
+	//Only load cues another gun hasn't already warmed up
+	TArray<int32> NewCues;
+	TArray<FSoftObjectPath> CuePaths;
+	for (const FGameplayTag& Tag : CueTags)
+	{
+		if (WarmedTags.HasTagExact(Tag))
+		{
+			continue;
+		}
+		WarmedTags.AddTag(Tag);
+
+		//Skip top level families so every cue in the game doesn't count
+		const FGameplayTag Family = Tag.RequestDirectParent();
+		if (Family.RequestDirectParent().IsValid())
+		{
+			WarmedFamilies.AddTag(Family);
+		}
+
+		if (const int32* DataIndex = CueSet->GameplayCueDataMap.Find(Tag))
+		{
+			NewCues.Add(*DataIndex);
+			CuePaths.Add(CueSet->GameplayCueData[*DataIndex].GameplayCueNotifyObj);
+		}
+	}
+
+	if (NewCues.IsEmpty())
+	{
+		return;
+	}
+
+	//Load now instead of on the first shot, the handle keeps them loaded for the rest of the round
+	LoadHandles.Add(UAssetManager::GetStreamableManager().RequestSyncLoad(CuePaths));
+
+	UGameplayCueManager* CueManager = UAbilitySystemGlobals::Get().GetGameplayCueManager();
+	int32 ActorsToPrewarm = 0;
+	for (const int32 DataIndex : NewCues)
+	{
+		FGameplayCueNotifyData& CueData = CueSet->GameplayCueData[DataIndex];
+		UClass* CueClass = Cast<UClass>(CueData.GameplayCueNotifyObj.ResolveObject());
+		if (!CueClass)
+		{
+			UE_LOG(LogGunCueWarmup, Warning, TEXT("Gun cue %s failed to load"), *CueData.GameplayCueTag.ToString());
+			continue;
+		}
+
+		//Same as the cue set does when it finds the class loaded, saves the lookup on the first shot
+		CueData.LoadedGameplayCueClass = CueClass;
+		ResidentCues.Add(DataIndex);
+
+		//Actor cues get recycled through the cue manager's pool, fill it before the first shots need them
+		if (const AGameplayCueNotify_Actor* ActorCue = Cast<AGameplayCueNotify_Actor>(CueClass->GetDefaultObject()))
+		{
+			CueManager->CheckForPreallocation(CueClass);
+			ActorsToPrewarm += ActorCue->NumPreallocatedInstances;
+		}
+	}
+
+	//The cue manager spawns one pooled actor per update
+	for (int32 Index = 0; Index < ActorsToPrewarm; Index++)
+	{
+		CueManager->UpdatePreallocation(GetWorld());
+	}
+
+	UE_LOG(
+		LogGunCueWarmup,
+		Log,
+		TEXT("Warmed up %d gun cues and %d pooled cue actors in %.2f ms"),
+		NewCues.Num(),
+		ActorsToPrewarm,
+		(FPlatformTime::Seconds() - StartTime) * 1000);
+}
+
+int32 UGunCueWarmupSubsystem::CountLateLoads() const
+{
+	const UGameplayCueSet* CueSet = GetRuntimeCueSet();
+	if (!CueSet)
+	{
+		return 0;
+	}
+
+	int32 LateLoads = 0;
+	for (int32 DataIndex = 0; DataIndex < CueSet->GameplayCueData.Num(); DataIndex++)
+	{
+		const FGameplayCueNotifyData& CueData = CueSet->GameplayCueData[DataIndex];
+		if (!CueData.LoadedGameplayCueClass || ResidentCues.Contains(DataIndex))
+		{
+			continue;
+		}
+
+		if (WarmedTags.HasTagExact(CueData.GameplayCueTag) || CueData.GameplayCueTag.MatchesAny(WarmedFamilies))
+		{
+			UE_LOG(LogGunCueWarmup, Warning, TEXT("Gun cue %s loaded after warmup"), *CueData.GameplayCueTag.ToString());
+			LateLoads++;
+		}
+	}
+
+	return LateLoads;
+}
@@ -0,0 +1,44 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "GameplayTagContainer.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GunCueWarmupSubsystem.generated.h"
+
+struct FStreamableHandle;
+class UGameplayCueSet;
+
+//Loads gun cue notifies and fills the cue manager's actor pool when guns spawn so the first shot of a match doesn't
+//hitch. Cues in the same families that still load mid round are reported when the world ends.
+UCLASS()
+class Y25_API UGunCueWarmupSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//Load any cues in CueTags that aren't warm yet and prespawn their pooled actors
+	void Warmup(const FGameplayTagContainer& CueTags);
+
+	//Gun cues that loaded after warming up, each one is a hitch the warmup missed
+	int32 CountLateLoads() const;
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	static UGameplayCueSet* GetRuntimeCueSet();
+
+	FGameplayTagContainer WarmedTags;
+
+	//Parents of the warmed tags, loads under these are counted as late
+	FGameplayTagContainer WarmedFamilies;
+
+	//Cue data indices that were loaded by, or before, the warmup
+	TSet<int32> ResidentCues;
+
+	TArray<TSharedPtr<FStreamableHandle>> LoadHandles;
+};
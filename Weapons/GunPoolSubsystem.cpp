@@ -0,0 +1,80 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "GunPoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "Y25/Weapons/Gun.h"
+
+bool UGunPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGunPoolSubsystem::Deinitialize()
+{
+	Parked.Empty();
+
+	Super::Deinitialize();
+}
+
+AGun* UGunPoolSubsystem::Acquire(
+	const TSubclassOf<AGun> GunClass,
+	AController* Player,
+	AActor* Owner,
+	const FTransform& Transform)
+{
+	if (!GunClass || !Player)
+	{
+		return nullptr;
+	}
+
+	//A gun of another class can't be reset into this one
+	TObjectPtr<AGun> Gun;
+	Parked.RemoveAndCopyValue(Player, Gun);
+	if (IsValid(Gun) && Gun->GetClass() != GunClass)
+	{
+		Gun->Destroy();
+		Gun = nullptr;
+	}
+
+	if (!IsValid(Gun))
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.Owner = Owner;
+		SpawnParameters.Instigator = Cast<APawn>(Owner);
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Gun = GetWorld()->SpawnActor<AGun>(GunClass, Transform, SpawnParameters);
+		if (Gun)
+		{
+			Gun->PoolPlayer = Player;
+		}
+		return Gun;
+	}
+
+	Gun->SetActorTransform(Transform);
+	Gun->ActivateFromPool(Owner);
+
+	return Gun;
+}
+
+bool UGunPoolSubsystem::Release(AGun* Gun)
+{
+	AController* Player = Gun ? Gun->PoolPlayer.Get() : nullptr;
+	if (!Player)
+	{
+		return false;
+	}
+
+	//Only one gun per player is kept
+	if (const TObjectPtr<AGun>* Previous = Parked.Find(Player); Previous && IsValid(*Previous) && *Previous != Gun)
+	{
+		(*Previous)->Destroy();
+	}
+
+	Gun->DeactivateToPool();
+	Parked.Add(Player, Gun);
+
+	return true;
+}
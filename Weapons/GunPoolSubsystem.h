@@ -0,0 +1,33 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "GunPoolSubsystem.generated.h"
+
+class AController;
+class AGun;
+
+//Keeps each player's gun alive through death so a respawn resets it instead of spawning a new one
+UCLASS()
+class Y25_API UGunPoolSubsystem final : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//The player's parked gun reset to its starting loadout and handed to Owner, spawned if they have none
+	AGun* Acquire(TSubclassOf<AGun> GunClass, AController* Player, AActor* Owner, const FTransform& Transform);
+
+	//Park the gun for its player's next life instead of destroying it, returns false if it has no player
+	bool Release(AGun* Gun);
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<AController>, TObjectPtr<AGun>> Parked;
+};
@@ -22,6 +22,10 @@ public:
 	UPROPERTY(BlueprintReadOnly)
 	EAmmoType AmmoType;
 
+	//The gun audio subsystem already played this shot, the cue should skip its own shot sound
+	UPROPERTY(BlueprintReadOnly)
+	bool bShotAudioHandled = false;
+
 	UPROPERTY(BlueprintReadOnly)
 	TObjectPtr<USkeletalMeshComponent> GunMesh;
 };
@@ -0,0 +1,101 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/UObjectIterator.h"
+#include "Y25/Combat/TargetIndexSubsystem.h"
+#include "Y25/Enemies/BaseEnemy.h"
+#include "Y25/Weapons/Gun.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 NumPlayers = 4;
+	constexpr int32 NumEnemies = 200;
+	constexpr int32 NumFrames = 500;
+
+	//BaseEnemy may be abstract, use the first concrete enemy class there is
+	UClass* FindEnemyClass()
+	{
+		for (TObjectIterator<UClass> It; It; ++It)
+		{
+			if (It->IsChildOf(ABaseEnemy::StaticClass()) &&
+				!It->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists))
+			{
+				return *It;
+			}
+		}
+		return nullptr;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FAimAssistBenchmarkTest,
+	"Y25.Weapons.AimAssist.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FAimAssistBenchmarkTest::RunTest(const FString& Parameters)
+{
+	UClass* EnemyClass = FindEnemyClass();
+	if (!EnemyClass)
+	{
+		AddWarning(TEXT("No concrete enemy class loaded, skipping"));
+		return true;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	//Enemies in a ring in front of the players, the index picks them up as they spawn
+	FRandomStream Stream(NumEnemies);
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	for (int32 Index = 0; Index < NumEnemies; Index++)
+	{
+		const FVector Location(Stream.FRandRange(500, 5000), Stream.FRandRange(-2000, 2000), Stream.FRandRange(0, 500));
+		World->SpawnActor<APawn>(EnemyClass, Location, FRotator::ZeroRotator, SpawnParams);
+	}
+	World->GetSubsystem<UTargetIndexSubsystem>()->Tick(0);
+
+	//Players spread out, all looking down +X and sweeping slightly each frame
+	TArray<FMinimalViewInfo> Views;
+	for (int32 Player = 0; Player < NumPlayers; Player++)
+	{
+		FMinimalViewInfo& ViewInfo = Views.AddDefaulted_GetRef();
+		ViewInfo.Location = FVector(0, (Player - NumPlayers / 2) * 300, 170);
+	}
+
+	const FCollisionQueryParams QueryParams;
+	TArray<APawn*> Candidates;
+	int32 NumTargeted = 0;
+
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		for (FMinimalViewInfo& ViewInfo : Views)
+		{
+			ViewInfo.Rotation = FRotator(0, FMath::Sin(Frame * 0.05) * 30, 0);
+			NumTargeted += AGun::FindAimAssistTarget(World, ViewInfo, 8, 10000, QueryParams, Candidates) ? 1 : 0;
+		}
+	}
+	const double FrameTime = (FPlatformTime::Seconds() - StartTime) / NumFrames * 1000000;
+
+	AddInfo(FString::Printf(
+		TEXT("%d players vs %d enemies: %.2f us/frame, target found %.0f%% of the time"),
+		NumPlayers,
+		NumEnemies,
+		FrameTime,
+		100.0 * NumTargeted / (NumFrames * NumPlayers)));
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,128 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "AudioDevice.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Sound/SoundWave.h"
+#include "Y25/Weapons/Gun.h"
+#include "Y25/Weapons/GunAudioSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	USoundWave* MakeSound(const float Duration, const bool bLooping = false)
+	{
+		USoundWave* Sound = NewObject<USoundWave>();
+		Sound->Duration = Duration;
+		Sound->bLooping = bLooping;
+		return Sound;
+	}
+
+	//Config values are private, read them the way the config system wrote them
+	template <typename PropertyType, typename ValueType>
+	ValueType GetConfigValue(const UObject* Object, const FName Name)
+	{
+		const PropertyType* Property = FindFProperty<PropertyType>(Object->GetClass(), Name);
+		return Property ? Property->GetPropertyValue_InContainer(Object) : ValueType();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGunAudioBurstTest,
+	"Y25.Weapons.GunAudio.Burst",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ProductFilter)
+
+bool FGunAudioBurstTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	//Voices are counted by duration only without a device, a real one would also stop them early
+	if (World->GetAudioDevice().IsValid())
+	{
+		AddWarning(TEXT("Needs the null audio device, run with -nosound"));
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		return true;
+	}
+
+	UGunAudioSubsystem* GunAudio = World->GetSubsystem<UGunAudioSubsystem>();
+	if (!TestNotNull(TEXT("Gun audio subsystem"), GunAudio))
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		return false;
+	}
+
+	const int32 MaxVoicesPerGun = GetConfigValue<FIntProperty, int32>(GunAudio, TEXT("MaxVoicesPerGun"));
+	const int32 SustainAfterShots = GetConfigValue<FIntProperty, int32>(GunAudio, TEXT("SustainAfterShots"));
+	const float SustainReleaseIntervals = GetConfigValue<FFloatProperty, float>(GunAudio, TEXT("SustainReleaseIntervals"));
+
+	//Never finished, so BeginPlay and its loadout don't run
+	AGun* Gun = World->SpawnActorDeferred<AGun>(AGun::StaticClass(), FTransform::Identity);
+	FGunShotAudio* ShotAudio = FindFProperty<FStructProperty>(AGun::StaticClass(), TEXT("ShotAudio"))->
+		ContainerPtrToValuePtr<FGunShotAudio>(Gun);
+	ShotAudio->ShotSound = MakeSound(10);
+	ShotAudio->SustainSound = MakeSound(10, true);
+	ShotAudio->SustainTailSound = MakeSound(10);
+	ShotAudio->SustainShotsPerSecond = 10;
+
+	constexpr float ShotInterval = 0.05f;
+	auto Fire = [World, GunAudio, Gun](const float DeltaTime)
+	{
+		World->TimeSeconds += DeltaTime;
+		GunAudio->Shot(Gun);
+		GunAudio->Tick(DeltaTime);
+	};
+
+	//One voice per shot until the burst is fast enough to sustain
+	for (int32 Shot = 1; Shot <= SustainAfterShots; Shot++)
+	{
+		Fire(ShotInterval);
+		TestFalse(FString::Printf(TEXT("Sustaining after %d shots"), Shot), GunAudio->IsSustaining(Gun));
+		TestEqual(
+			FString::Printf(TEXT("Voices after %d shots"), Shot),
+			GunAudio->GetNumVoices(Gun),
+			FMath::Min(Shot, MaxVoicesPerGun));
+	}
+
+	//Next fast shot starts the loop with the shot sound as its start tail
+	Fire(ShotInterval);
+	TestTrue(TEXT("Sustaining once the burst is fast"), GunAudio->IsSustaining(Gun));
+	TestTrue(TEXT("Voices within budget"), GunAudio->GetNumVoices(Gun) <= MaxVoicesPerGun);
+
+	//The loop covers the rest of the burst
+	const int32 SustainVoices = GunAudio->GetNumVoices(Gun);
+	for (int32 Shot = 0; Shot < 20; Shot++)
+	{
+		Fire(ShotInterval);
+	}
+	TestTrue(TEXT("Still sustaining during the burst"), GunAudio->IsSustaining(Gun));
+	TestEqual(TEXT("Sustained shots add no voices"), GunAudio->GetNumVoices(Gun), SustainVoices);
+
+	//Stopping plays the tail
+	const float ReleaseTime = ShotInterval * SustainReleaseIntervals + ShotInterval;
+	World->TimeSeconds += ReleaseTime;
+	GunAudio->Tick(ReleaseTime);
+	TestFalse(TEXT("Sustain released after the burst"), GunAudio->IsSustaining(Gun));
+	TestEqual(
+		TEXT("Tail voice after the burst"),
+		GunAudio->GetNumVoices(Gun),
+		FMath::Min(SustainVoices + 1, MaxVoicesPerGun));
+
+	//Every voice has finished by the next lone shot
+	Fire(20);
+	TestFalse(TEXT("Lone shot doesn't sustain"), GunAudio->IsSustaining(Gun));
+	TestEqual(TEXT("Finished voices are pruned"), GunAudio->GetNumVoices(Gun), 1);
+
+	Gun->Destroy();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return true;
+}
+
+#endif
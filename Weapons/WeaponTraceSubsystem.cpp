@@ -0,0 +1,262 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#include "WeaponTraceSubsystem.h"
+
+#include "Algo/StableSort.h"
+#include "Async/ParallelFor.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Y25/Values/Collision.h"
+#include "Y25/Weapons/Gun.h"
+
+bool UWeaponTraceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UWeaponTraceSubsystem::Deinitialize()
+{
+	AimTraces.Empty();
+	ShotTraces.Empty();
+	FinishedAims.Empty();
+	FinishedShots.Empty();
+	PelletDirections.Empty();
+	PelletHits.Empty();
+	PelletPierceHits.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UWeaponTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWeaponTraceSubsystem, STATGROUP_Tickables);
+}
+
+void UWeaponTraceSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Flush();
+}
+
+int32 UWeaponTraceSubsystem::GetPlayerIndex(const AGun* Gun)
+{
+	const AActor* Owner = Gun->GetOwner();
+	const APlayerController* PlayerController =
+		Owner ? Cast<APlayerController>(Owner->GetInstigatorController()) : nullptr;
+	const ULocalPlayer* LocalPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	return LocalPlayer ? LocalPlayer->GetLocalPlayerIndex() : MAX_int32;
+}
+
+void UWeaponTraceSubsystem::RequestAim(AGun* Gun, const FVector& Start, const FVector& End)
+{
+	FAimTrace& AimTrace = AimTraces.AddDefaulted_GetRef();
+	AimTrace.Gun = Gun;
+	AimTrace.PlayerIndex = GetPlayerIndex(Gun);
+	AimTrace.Start = Start;
+	AimTrace.End = End;
+	AimTrace.GunActor = Gun;
+	AimTrace.Owner = Gun->GetOwner();
+}
+
+void UWeaponTraceSubsystem::RequestShot(AGun* Gun, const FWeaponShotRequest& Shot)
+{
+	FShotTrace& ShotTrace = ShotTraces.AddDefaulted_GetRef();
+	ShotTrace.Gun = Gun;
+	ShotTrace.PlayerIndex = GetPlayerIndex(Gun);
+	ShotTrace.Shot = Shot;
+	ShotTrace.GunActor = Gun;
+	ShotTrace.Owner = Gun->GetOwner();
+}
+
+void UWeaponTraceSubsystem::TraceShot(const FShotTrace& ShotTrace)
+{
+	const UWorld* World = GetWorld();
+	const FWeaponShotRequest& Shot = ShotTrace.Shot;
+
+	//Ignore gun and player
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WeaponShot), false);
+	QueryParams.AddIgnoredActor(ShotTrace.GunActor);
+	QueryParams.AddIgnoredActor(ShotTrace.Owner);
+
+	//One camera trace for every pellet, same as GetSpreadPoint
+	FHitResult ViewHit;
+	World->LineTraceSingleByChannel(
+		ViewHit,
+		Shot.ViewLocation + Shot.ViewDirection * 25,
+		Shot.ViewLocation + Shot.ViewDirection * Shot.Range,
+		Y25::Collision::Channels::Weapon,
+		QueryParams);
+
+	//Bullet and chain block on pawns, piercing passes through them
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(
+		Y25::Collision::Channels::Pawn,
+		Shot.AmmoType == EAmmoType::Piercing ? ECR_Overlap : ECR_Block);
+
+	FRandomStream Stream(Shot.Seed);
+	for (int32 Pellet = 0; Pellet < Shot.NumPellets; Pellet++)
+	{
+		const int32 Index = ShotTrace.FirstPellet + Pellet;
+
+		//Randomize spread
+		FVector SpreadPoint;
+		if (ViewHit.IsValidBlockingHit())
+		{
+			const FVector SpreadDirection = Stream.VRandCone(
+				ViewHit.ImpactPoint - Shot.ViewLocation,
+				Shot.SpreadHalfAngle);
+			const float NewRange = FVector::Dist(ViewHit.Location, Shot.ViewLocation) + 5;
+			SpreadPoint = Shot.ViewLocation + SpreadDirection * NewRange;
+		}
+		else
+		{
+			const FVector SpreadDirection = Stream.VRandCone(Shot.ViewDirection, Shot.SpreadHalfAngle);
+			SpreadPoint = Shot.GunLocation + SpreadDirection * Shot.Range;
+		}
+
+		const FVector Direction = (SpreadPoint - Shot.Muzzle).GetSafeNormal();
+		PelletDirections[Index] = Direction;
+
+		if (Shot.AmmoType == EAmmoType::Piercing)
+		{
+			World->LineTraceMultiByChannel(
+				PelletPierceHits[Index],
+				Shot.Muzzle,
+				Shot.Muzzle + Direction * Shot.PierceRange,
+				Y25::Collision::Channels::Weapon,
+				QueryParams,
+				ResponseParams);
+		}
+		else
+		{
+			World->LineTraceSingleByChannel(
+				PelletHits[Index],
+				Shot.Muzzle,
+				SpreadPoint,
+				Y25::Collision::Channels::Weapon,
+				QueryParams,
+				ResponseParams);
+		}
+	}
+}
+
+void UWeaponTraceSubsystem::Flush()
+{
+	if (AimTraces.IsEmpty() && ShotTraces.IsEmpty())
+	{
+		return;
+	}
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UWeaponTraceSubsystem::Flush);
+
+	//Player order first, then the order they were asked for, so results never depend on tick order or threads
+	Algo::StableSortBy(AimTraces, &FAimTrace::PlayerIndex);
+	Algo::StableSortBy(ShotTraces, &FShotTrace::PlayerIndex);
+
+	int32 NumPellets = 0;
+	for (FShotTrace& ShotTrace : ShotTraces)
+	{
+		ShotTrace.FirstPellet = NumPellets;
+		NumPellets += ShotTrace.Shot.NumPellets;
+	}
+
+	PelletDirections.SetNumUninitialized(NumPellets, EAllowShrinking::No);
+	PelletHits.Reset();
+	PelletHits.SetNum(NumPellets, EAllowShrinking::No);
+	PelletPierceHits.SetNum(NumPellets, EAllowShrinking::No);
+	for (TArray<FHitResult>& PierceHits : PelletPierceHits)
+	{
+		PierceHits.Reset();
+	}
+
+	//Aims and shots share one pass, each job only writes its own results. Scene queries take the physics
+	//read lock themselves, so traces from workers are safe.
+	const int32 NumAims = AimTraces.Num();
+	const int32 NumJobs = NumAims + ShotTraces.Num();
+	ParallelFor(NumJobs, [this, NumAims](const int32 Job)
+	{
+		if (Job >= NumAims)
+		{
+			TraceShot(ShotTraces[Job - NumAims]);
+			return;
+		}
+
+		FAimTrace& AimTrace = AimTraces[Job];
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WeaponAim), false);
+		QueryParams.AddIgnoredActor(AimTrace.GunActor);
+		QueryParams.AddIgnoredActor(AimTrace.Owner);
+
+		GetWorld()->LineTraceSingleByChannel(
+			AimTrace.Hit,
+			AimTrace.Start,
+			AimTrace.End,
+			Y25::Collision::Channels::Weapon,
+			QueryParams);
+	}, NumJobs < ParallelThreshold ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	//Swap out first so anything requested while handing back lands in next frame's batch
+	Swap(AimTraces, FinishedAims);
+	Swap(ShotTraces, FinishedShots);
+
+	for (const FAimTrace& AimTrace : FinishedAims)
+	{
+		if (AGun* Gun = AimTrace.Gun.Get())
+		{
+			Gun->ApplyAimTrace(AimTrace.Hit);
+		}
+	}
+
+	for (const FShotTrace& ShotTrace : FinishedShots)
+	{
+		for (int32 Pellet = 0; Pellet < ShotTrace.Shot.NumPellets; Pellet++)
+		{
+			//A pellet can kill the shooter and park the gun, which cancels the rest
+			AGun* Gun = ShotTrace.Gun.Get();
+			if (!Gun)
+			{
+				break;
+			}
+
+			const int32 Index = ShotTrace.FirstPellet + Pellet;
+			Gun->ApplyShotTrace(
+				ShotTrace.Shot.AmmoType,
+				PelletDirections[Index],
+				PelletHits[Index],
+				PelletPierceHits[Index]);
+		}
+	}
+
+	FinishedAims.Reset();
+	FinishedShots.Reset();
+}
+
+void UWeaponTraceSubsystem::CancelRequests(const AGun* Gun)
+{
+	AimTraces.RemoveAll([Gun](const FAimTrace& AimTrace)
+	{
+		return AimTrace.Gun == Gun;
+	});
+	ShotTraces.RemoveAll([Gun](const FShotTrace& ShotTrace)
+	{
+		return ShotTrace.Gun == Gun;
+	});
+
+	//Being handed back right now, clear rather than remove so the loop stays valid
+	for (FAimTrace& AimTrace : FinishedAims)
+	{
+		if (AimTrace.Gun == Gun)
+		{
+			AimTrace.Gun.Reset();
+		}
+	}
+	for (FShotTrace& ShotTrace : FinishedShots)
+	{
+		if (ShotTrace.Gun == Gun)
+		{
+			ShotTrace.Gun.Reset();
+		}
+	}
+}
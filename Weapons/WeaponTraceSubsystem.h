@@ -0,0 +1,97 @@
+﻿// Copyright Brigham Young University. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "WeaponTraceSubsystem.generated.h"
+
+class AGun;
+enum class EAmmoType : uint8;
+
+//Everything needed to trace one shot's pellets away from the gun
+struct FWeaponShotRequest
+{
+	FVector Muzzle = FVector::ZeroVector;
+	FVector GunLocation = FVector::ZeroVector;
+	FVector ViewLocation = FVector::ZeroVector;
+	FVector ViewDirection = FVector::ForwardVector;
+	float SpreadHalfAngle = 0;
+	float Range = 0;
+	float PierceRange = 0;
+	int32 NumPellets = 1;
+	//Ammo loaded when the shot was fired, results are handled for it even if the gun has switched since
+	EAmmoType AmmoType{};
+	int32 Seed = 0;
+};
+
+//Gathers every gun's aim and shot traces for the frame, runs them together across worker threads and hands the
+//results back player by player in the order they were asked for
+UCLASS(Config=Game)
+class Y25_API UWeaponTraceSubsystem final : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RequestAim(AGun* Gun, const FVector& Start, const FVector& End);
+
+	void RequestShot(AGun* Gun, const FWeaponShotRequest& Shot);
+
+	//Run and hand back everything requested so far
+	void Flush();
+
+	//Forget Gun's aim and shot requests, including any not yet handed back
+	void CancelRequests(const AGun* Gun);
+
+protected:
+	virtual bool DoesSupportWorldType(EWorldType::Type WorldType) const override;
+
+private:
+	struct FAimTrace
+	{
+		TWeakObjectPtr<AGun> Gun;
+		int32 PlayerIndex = 0;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+		const AActor* GunActor = nullptr;
+		const AActor* Owner = nullptr;
+		FHitResult Hit;
+	};
+
+	struct FShotTrace
+	{
+		TWeakObjectPtr<AGun> Gun;
+		int32 PlayerIndex = 0;
+		FWeaponShotRequest Shot;
+		const AActor* GunActor = nullptr;
+		const AActor* Owner = nullptr;
+		//Where this shot's pellets start in the pellet arrays
+		int32 FirstPellet = 0;
+	};
+
+	//Fewer traces than this run on the game thread
+	UPROPERTY(Config)
+	int32 ParallelThreshold = 8;
+
+	static int32 GetPlayerIndex(const AGun* Gun);
+
+	void TraceShot(const FShotTrace& ShotTrace);
+
+	TArray<FAimTrace> AimTraces;
+	TArray<FShotTrace> ShotTraces;
+
+	//Swapped with the requests while results are handed back
+	TArray<FAimTrace> FinishedAims;
+	TArray<FShotTrace> FinishedShots;
+
+	//One entry per pellet across every shot this frame
+	TArray<FVector> PelletDirections;
+	TArray<FHitResult> PelletHits;
+	TArray<TArray<FHitResult>> PelletPierceHits;
+};